@@ -0,0 +1,407 @@
+// poll, close and O_CLOEXEC need posix in strict c99
+#define _POSIX_C_SOURCE 200809L
+#include "KeyPadLinux.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/gpio.h>
+
+#define __lineMask(LEN)                 ((LEN) >= 64 ? ~(uint64_t) 0 : (((uint64_t) 1 << (LEN)) - 1))
+#define __inGroup(G, C)                 ((G)->Configs != 0 && (C) >= (G)->Configs && (C) < (G)->Configs + (G)->Len)
+#define __EDGES                         (GPIO_V2_LINE_FLAG_EDGE_RISING | GPIO_V2_LINE_FLAG_EDGE_FALLING)
+
+/**
+ * @brief hold a line request, lines of request are pins of a pin array in same order
+ */
+typedef struct {
+    const KeyPad_PinConfig*     Configs;                    /**< pin array of request, null if slot is free */
+    KeyPad_LenType              Len;                        /**< number of lines */
+    int                         Fd;                         /**< fd of line request */
+    uint64_t                    Flags;                      /**< current flags of lines, all lines have same flags */
+    uint64_t                    Values;                     /**< last written values, bit N is N-th pin of array */
+    uint8_t                     Wake;                       /**< edge events of lines enabled */
+} KeyPadLinux_Group;
+
+/* private variables */
+static KeyPadLinux_Group linuxGroups[KEYPADLINUX_MAX_GROUPS];
+static KeyPadLinux_Group* linuxLast = 0;                    /**< last used group, pins of a strobe are in same group */
+static int linuxError = 0;
+
+static void KeyPadLinux_initPin(const KeyPad_PinConfig* config, KeyPad_PinMode mode);
+static uint8_t KeyPadLinux_readPin(const KeyPad_PinConfig* config);
+static void KeyPadLinux_writePin(const KeyPad_PinConfig* config, uint8_t value);
+#if KEYPAD_USE_DEINIT
+static void KeyPadLinux_deinitPin(const KeyPad_PinConfig* config);
+#endif // KEYPAD_USE_DEINIT
+#if KEYPAD_USE_PORT
+static KeyPad_PortMask KeyPadLinux_readPort(const KeyPad_PinConfig* configs, KeyPad_LenType len);
+static void KeyPadLinux_writePort(const KeyPad_PinConfig* configs, KeyPad_LenType len, KeyPad_PortMask value);
+#endif // KEYPAD_USE_PORT
+#if KEYPAD_IDLE_WAKE
+static void KeyPadLinux_setWakePin(const KeyPad_PinConfig* config, uint8_t enable);
+#endif // KEYPAD_IDLE_WAKE
+static KeyPadLinux_Group* KeyPadLinux_find(const KeyPad_PinConfig* config);
+static void KeyPadLinux_setFlags(KeyPadLinux_Group* group, uint64_t flags);
+static uint64_t KeyPadLinux_getValues(KeyPadLinux_Group* group, uint64_t mask);
+static void KeyPadLinux_setValues(KeyPadLinux_Group* group, uint64_t mask);
+static int KeyPadLinux_drain(KeyPadLinux_Group* group);
+
+const KeyPad_Driver KeyPadLinux_driver = {
+    .initPin = KeyPadLinux_initPin,
+    .readPin = KeyPadLinux_readPin,
+    .writePin = KeyPadLinux_writePin,
+#if KEYPAD_USE_DEINIT
+    .deinitPin = KeyPadLinux_deinitPin,
+#endif
+#if KEYPAD_USE_PORT
+    .readPort = KeyPadLinux_readPort,
+    .writePort = KeyPadLinux_writePort,
+#endif
+#if KEYPAD_IDLE_WAKE
+    .setWakePin = KeyPadLinux_setWakePin,
+#endif
+};
+
+/**
+ * @brief request lines of a pin array with one line request, lines stay input until KeyPad_add init them
+ *
+ * @param chip path of gpio chip, ex: "/dev/gpiochip0"
+ * @param configs pin array, ex: Rows or Columns of KeyPad_Config, it must be alive while lines requested
+ * @param len number of pins, at most 64
+ * @return int 0 on success or negative errno
+ */
+int KeyPadLinux_request(const char* chip, const KeyPad_PinConfig* configs, KeyPad_LenType len) {
+    struct gpio_v2_line_request request;
+    KeyPadLinux_Group* group = 0;
+    KeyPad_LenType index;
+    int chipFd;
+    int result;
+    if (len <= 0 || len > GPIO_V2_LINES_MAX) {
+        return -EINVAL;
+    }
+    for (index = 0; index < KEYPADLINUX_MAX_GROUPS; index++) {
+        if (linuxGroups[index].Configs == 0) {
+            group = &linuxGroups[index];
+            break;
+        }
+    }
+    if (group == 0) {
+        return -ENOMEM;
+    }
+    chipFd = open(chip, O_RDWR | O_CLOEXEC);
+    if (chipFd < 0) {
+        return -errno;
+    }
+    memset(&request, 0, sizeof(request));
+    for (index = 0; index < len; index++) {
+        request.offsets[index] = configs[index].Pin;
+    }
+    request.num_lines = (uint32_t) len;
+    strncpy(request.consumer, KEYPADLINUX_CONSUMER, sizeof(request.consumer) - 1);
+    request.config.flags = GPIO_V2_LINE_FLAG_INPUT;
+    result = KEYPADLINUX_IOCTL(chipFd, GPIO_V2_GET_LINE_IOCTL, &request) < 0 ? -errno : 0;
+    // line request has its own fd
+    close(chipFd);
+    if (result) {
+        return result;
+    }
+    group->Configs = configs;
+    group->Len = len;
+    group->Fd = request.fd;
+    group->Flags = GPIO_V2_LINE_FLAG_INPUT;
+    group->Values = 0;
+    group->Wake = 0;
+    return 0;
+}
+/**
+ * @brief request rows and columns of a config
+ *
+ * @return int 0 on success or negative errno
+ */
+int KeyPadLinux_requestConfig(const char* chip, const KeyPad_Config* config) {
+    int result = KeyPadLinux_request(chip, config->Columns, config->ColumnsLen);
+    if (result) {
+        return result;
+    }
+    result = KeyPadLinux_request(chip, config->Rows, config->RowsLen);
+    if (result) {
+        KeyPadLinux_release(config->Columns);
+    }
+    return result;
+}
+/**
+ * @brief release lines of a pin array, keypad must be removed before it
+ */
+void KeyPadLinux_release(const KeyPad_PinConfig* configs) {
+    uint8_t index;
+    for (index = 0; index < KEYPADLINUX_MAX_GROUPS; index++) {
+        KeyPadLinux_Group* group = &linuxGroups[index];
+        if (group->Configs != 0 && group->Configs == configs) {
+            close(group->Fd);
+            group->Configs = 0;
+        }
+    }
+    linuxLast = 0;
+}
+void KeyPadLinux_releaseAll(void) {
+    uint8_t index;
+    for (index = 0; index < KEYPADLINUX_MAX_GROUPS; index++) {
+        if (linuxGroups[index].Configs != 0) {
+            KeyPadLinux_release(linuxGroups[index].Configs);
+        }
+    }
+}
+/**
+ * @brief wait for edge of input lines that setWakePin enabled, then call KeyPad_wake
+ * user can call it instead of sleep when KeyPad_isIdle
+ *
+ * @param timeout timeout in milliseconds, -1 wait forever
+ * @return int number of edge events, 0 on timeout or negative errno
+ */
+int KeyPadLinux_wait(int timeout) {
+    struct pollfd fds[KEYPADLINUX_MAX_GROUPS];
+    KeyPadLinux_Group* groups[KEYPADLINUX_MAX_GROUPS];
+    uint8_t len = 0;
+    uint8_t index;
+    int events = 0;
+    int result;
+    for (index = 0; index < KEYPADLINUX_MAX_GROUPS; index++) {
+        if (linuxGroups[index].Configs != 0 && linuxGroups[index].Wake) {
+            fds[len].fd = linuxGroups[index].Fd;
+            fds[len].events = POLLIN;
+            fds[len].revents = 0;
+            groups[len++] = &linuxGroups[index];
+        }
+    }
+    if (len == 0) {
+        return 0;
+    }
+    result = poll(fds, len, timeout);
+    if (result <= 0) {
+        return result < 0 ? -errno : 0;
+    }
+    for (index = 0; index < len; index++) {
+        if (fds[index].revents & POLLIN) {
+            events += KeyPadLinux_drain(groups[index]);
+        }
+    }
+#if KEYPAD_IDLE_WAKE
+    if (events) {
+        KeyPad_wake();
+    }
+#endif // KEYPAD_IDLE_WAKE
+    return events;
+}
+/**
+ * @brief return last error of driver functions and clear it
+ *
+ * @return int negative errno, 0 if there is no error
+ */
+int KeyPadLinux_getError(void) {
+    int error = linuxError;
+    linuxError = 0;
+    return error;
+}
+
+/**
+ * @brief set mode of all lines of pin array, only first pin of array need ioctl
+ */
+static void KeyPadLinux_initPin(const KeyPad_PinConfig* config, KeyPad_PinMode mode) {
+    KeyPadLinux_Group* group = KeyPadLinux_find(config);
+    uint64_t flags;
+    if (group == 0) {
+        return;
+    }
+    switch (mode) {
+        case KeyPad_PinMode_InputPullUp:
+            flags = GPIO_V2_LINE_FLAG_INPUT | GPIO_V2_LINE_FLAG_BIAS_PULL_UP;
+            break;
+        case KeyPad_PinMode_InputPullDown:
+            flags = GPIO_V2_LINE_FLAG_INPUT | GPIO_V2_LINE_FLAG_BIAS_PULL_DOWN;
+            break;
+        case KeyPad_PinMode_Output:
+            flags = GPIO_V2_LINE_FLAG_OUTPUT;
+            break;
+        default:
+            flags = GPIO_V2_LINE_FLAG_INPUT;
+            break;
+    }
+    if (group->Flags != flags) {
+        KeyPadLinux_setFlags(group, flags);
+    }
+}
+static uint8_t KeyPadLinux_readPin(const KeyPad_PinConfig* config) {
+    KeyPadLinux_Group* group = KeyPadLinux_find(config);
+    uint64_t bit;
+    if (group == 0) {
+        return 0;
+    }
+    bit = (uint64_t) 1 << (config - group->Configs);
+    return (KeyPadLinux_getValues(group, bit) & bit) != 0;
+}
+/**
+ * @brief write an output, value of lines that are not output yet apply when they become output
+ */
+static void KeyPadLinux_writePin(const KeyPad_PinConfig* config, uint8_t value) {
+    KeyPadLinux_Group* group = KeyPadLinux_find(config);
+    uint64_t bit;
+    if (group == 0) {
+        return;
+    }
+    bit = (uint64_t) 1 << (config - group->Configs);
+    if (value) {
+        group->Values |= bit;
+    }
+    else {
+        group->Values &= ~bit;
+    }
+    if (group->Flags & GPIO_V2_LINE_FLAG_OUTPUT) {
+        KeyPadLinux_setValues(group, bit);
+    }
+}
+#if KEYPAD_USE_DEINIT
+/**
+ * @brief return lines into input without bias, lines stay requested until KeyPadLinux_release
+ */
+static void KeyPadLinux_deinitPin(const KeyPad_PinConfig* config) {
+    KeyPadLinux_Group* group = KeyPadLinux_find(config);
+    if (group != 0 && group->Flags != GPIO_V2_LINE_FLAG_INPUT) {
+        KeyPadLinux_setFlags(group, GPIO_V2_LINE_FLAG_INPUT);
+        group->Wake = 0;
+    }
+}
+#endif // KEYPAD_USE_DEINIT
+#if KEYPAD_USE_PORT
+/**
+ * @brief read pins of array with one GPIO_V2_LINE_GET_VALUES_IOCTL
+ */
+static KeyPad_PortMask KeyPadLinux_readPort(const KeyPad_PinConfig* configs, KeyPad_LenType len) {
+    KeyPadLinux_Group* group = KeyPadLinux_find(configs);
+    long offset;
+    if (group == 0) {
+        return 0;
+    }
+    offset = configs - group->Configs;
+    return (KeyPad_PortMask) (KeyPadLinux_getValues(group, __lineMask(len) << offset) >> offset);
+}
+/**
+ * @brief write pins of array with one GPIO_V2_LINE_SET_VALUES_IOCTL
+ */
+static void KeyPadLinux_writePort(const KeyPad_PinConfig* configs, KeyPad_LenType len, KeyPad_PortMask value) {
+    KeyPadLinux_Group* group = KeyPadLinux_find(configs);
+    uint64_t mask;
+    long offset;
+    if (group == 0) {
+        return;
+    }
+    offset = configs - group->Configs;
+    mask = __lineMask(len) << offset;
+    group->Values = (group->Values & ~mask) | (((uint64_t) value << offset) & mask);
+    if (group->Flags & GPIO_V2_LINE_FLAG_OUTPUT) {
+        KeyPadLinux_setValues(group, mask);
+    }
+}
+#endif // KEYPAD_USE_PORT
+#if KEYPAD_IDLE_WAKE
+/**
+ * @brief enable edge events of input lines on their active edge, only first pin of array need ioctl
+ */
+static void KeyPadLinux_setWakePin(const KeyPad_PinConfig* config, uint8_t enable) {
+    KeyPadLinux_Group* group = KeyPadLinux_find(config);
+    uint64_t flags;
+    if (group == 0) {
+        return;
+    }
+    flags = group->Flags & ~(uint64_t) __EDGES;
+    if (enable) {
+        // pull-down inputs are active high
+        flags |= (flags & GPIO_V2_LINE_FLAG_BIAS_PULL_DOWN) ? GPIO_V2_LINE_FLAG_EDGE_RISING : GPIO_V2_LINE_FLAG_EDGE_FALLING;
+    }
+    if (group->Flags != flags) {
+        KeyPadLinux_setFlags(group, flags);
+        if (!enable) {
+            // events of last idle period are not needed anymore
+            KeyPadLinux_drain(group);
+        }
+    }
+    group->Wake = enable;
+}
+#endif // KEYPAD_IDLE_WAKE
+/**
+ * @brief find line request of a pin
+ */
+static KeyPadLinux_Group* KeyPadLinux_find(const KeyPad_PinConfig* config) {
+    uint8_t index;
+    if (linuxLast != 0 && __inGroup(linuxLast, config)) {
+        return linuxLast;
+    }
+    for (index = 0; index < KEYPADLINUX_MAX_GROUPS; index++) {
+        if (__inGroup(&linuxGroups[index], config)) {
+            linuxLast = &linuxGroups[index];
+            return linuxLast;
+        }
+    }
+    linuxError = -ENOENT;
+    return 0;
+}
+/**
+ * @brief change flags of all lines of request, outputs start with last written values
+ */
+static void KeyPadLinux_setFlags(KeyPadLinux_Group* group, uint64_t flags) {
+    struct gpio_v2_line_config config;
+    memset(&config, 0, sizeof(config));
+    config.flags = flags;
+    if (flags & GPIO_V2_LINE_FLAG_OUTPUT) {
+        config.num_attrs = 1;
+        config.attrs[0].attr.id = GPIO_V2_LINE_ATTR_ID_OUTPUT_VALUES;
+        config.attrs[0].attr.values = group->Values;
+        config.attrs[0].mask = __lineMask(group->Len);
+    }
+    if (KEYPADLINUX_IOCTL(group->Fd, GPIO_V2_LINE_SET_CONFIG_IOCTL, &config) < 0) {
+        linuxError = -errno;
+        return;
+    }
+    group->Flags = flags;
+}
+static uint64_t KeyPadLinux_getValues(KeyPadLinux_Group* group, uint64_t mask) {
+    struct gpio_v2_line_values values;
+    values.bits = 0;
+    values.mask = mask;
+    if (KEYPADLINUX_IOCTL(group->Fd, GPIO_V2_LINE_GET_VALUES_IOCTL, &values) < 0) {
+        linuxError = -errno;
+        return 0;
+    }
+    return values.bits & mask;
+}
+static void KeyPadLinux_setValues(KeyPadLinux_Group* group, uint64_t mask) {
+    struct gpio_v2_line_values values;
+    values.bits = group->Values;
+    values.mask = mask;
+    if (KEYPADLINUX_IOCTL(group->Fd, GPIO_V2_LINE_SET_VALUES_IOCTL, &values) < 0) {
+        linuxError = -errno;
+    }
+}
+/**
+ * @brief read pending edge events of request without block
+ *
+ * @return int number of events
+ */
+static int KeyPadLinux_drain(KeyPadLinux_Group* group) {
+    struct gpio_v2_line_event events[16];
+    struct pollfd fd;
+    int count = 0;
+    fd.fd = group->Fd;
+    fd.events = POLLIN;
+    fd.revents = 0;
+    while (poll(&fd, 1, 0) > 0 && (fd.revents & POLLIN)) {
+        ssize_t len = read(group->Fd, events, sizeof(events));
+        if (len <= 0) {
+            break;
+        }
+        count += (int) ((size_t) len / sizeof(events[0]));
+    }
+    return count;
+}
@@ -0,0 +1,63 @@
+/**
+ * @file KeyPadLinux.h
+ * @author Ali Mirghasemi (ali.mirghasemi1376@gmail.com)
+ * @brief KeyPad_Driver for embedded linux boards, use gpio v2 character device
+ * each pin array of config is one line request, so a port read or write is one ioctl
+ * @version 0.1.0
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef _KEYPAD_LINUX_H_
+#define _KEYPAD_LINUX_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "KeyPad.h"
+
+/******************************************************************************/
+/*                                Configuration                               */
+/******************************************************************************/
+
+/**
+ * @brief maximum number of pin arrays that can request, each keypad need two (rows and columns)
+ */
+#define KEYPADLINUX_MAX_GROUPS              8
+/**
+ * @brief consumer name of requested lines
+ */
+#define KEYPADLINUX_CONSUMER                "keypad"
+/**
+ * @brief ioctl function that driver use, tests can define it before include to replace it with a mock
+ */
+#ifndef KEYPADLINUX_IOCTL
+    #define KEYPADLINUX_IOCTL               ioctl
+#endif
+
+/******************************************************************************/
+
+/**
+ * @brief driver of gpio character device, pass it to KeyPad_init
+ * Pin of KeyPad_PinConfig is line offset in chip and IO of KeyPad_PinConfig ignored
+ * pins of a config must request with KeyPadLinux_request or KeyPadLinux_requestConfig before KeyPad_add
+ * setWakePin enable edge events of input lines, KeyPadLinux_wait wait for them
+ */
+extern const KeyPad_Driver KeyPadLinux_driver;
+
+int KeyPadLinux_request(const char* chip, const KeyPad_PinConfig* configs, KeyPad_LenType len);
+int KeyPadLinux_requestConfig(const char* chip, const KeyPad_Config* config);
+void KeyPadLinux_release(const KeyPad_PinConfig* configs);
+void KeyPadLinux_releaseAll(void);
+
+int KeyPadLinux_wait(int timeout);
+int KeyPadLinux_getError(void);
+
+#ifdef __cplusplus
+};
+#endif
+
+#endif /* _KEYPAD_LINUX_H_ */
@@ -0,0 +1,132 @@
+#include "KeyPadShiftReg.h"
+
+// pins out of word of chain have no bit, so shift never overflow, out of chain inputs read idle level
+#define __isBit(P)                      ((P) < KEYPADSR_MAX_BITS)
+#define __bit(P)                        (__isBit(P) ? (KeyPadShiftReg_Word) 1 << (P) : 0)
+#define __getBit(W, P)                  (__isBit(P) ? (uint8_t) (((W) >> (P)) & 1) : srInIdle)
+
+/* private variables */
+static const KeyPadShiftReg_Bus* srBus;
+static uint8_t srOutBits;
+static uint8_t srInBits;
+static KeyPadShiftReg_Word srOut;                           /**< last value that shifted into 595 chain */
+static KeyPadShiftReg_Word srIn;                            /**< last value that shifted out of 165 chain */
+static KeyPadShiftReg_Word srInRead;                        /**< bits of srIn that read after last shift */
+static uint8_t srInvalidPins;                               /**< number of initialized pins that are out of their chain */
+static uint8_t srInIdle = 1;                                /**< level of inputs that are out of chain, follow pull of last input */
+
+static void KeyPadShiftReg_initPin(const KeyPad_PinConfig* config, KeyPad_PinMode mode);
+static uint8_t KeyPadShiftReg_readPin(const KeyPad_PinConfig* config);
+static void KeyPadShiftReg_writePin(const KeyPad_PinConfig* config, uint8_t value);
+#if KEYPAD_USE_PORT
+static KeyPad_PortMask KeyPadShiftReg_readPort(const KeyPad_PinConfig* configs, KeyPad_LenType len);
+static void KeyPadShiftReg_writePort(const KeyPad_PinConfig* configs, KeyPad_LenType len, KeyPad_PortMask value);
+#endif // KEYPAD_USE_PORT
+static void KeyPadShiftReg_shiftIn(void);
+static void KeyPadShiftReg_shiftOut(void);
+
+const KeyPad_Driver KeyPadShiftReg_driver = {
+    .initPin = KeyPadShiftReg_initPin,
+    .readPin = KeyPadShiftReg_readPin,
+    .writePin = KeyPadShiftReg_writePin,
+#if KEYPAD_USE_PORT
+    .readPort = KeyPadShiftReg_readPort,
+    .writePort = KeyPadShiftReg_writePort,
+#endif
+};
+
+/**
+ * @brief set serial functions and length of chains
+ * must call before KeyPad_init
+ * 
+ * @param bus serial functions of chains
+ * @param outBits number of bits of 595 chain, at most KEYPADSR_MAX_BITS
+ * @param inBits number of bits of 165 chain, at most KEYPADSR_MAX_BITS
+ */
+void KeyPadShiftReg_init(const KeyPadShiftReg_Bus* bus, uint8_t outBits, uint8_t inBits) {
+    srBus = bus;
+    srOutBits = outBits > KEYPADSR_MAX_BITS ? KEYPADSR_MAX_BITS : outBits;
+    srInBits = inBits > KEYPADSR_MAX_BITS ? KEYPADSR_MAX_BITS : inBits;
+    srInvalidPins = 0;
+    srOut = 0;
+    srIn = 0;
+    srInRead = ~(KeyPadShiftReg_Word) 0;
+}
+
+/**
+ * @brief return number of pins that KeyPad_add initialized and they are out of their chain
+ * these pins never drive and read idle level of their pull, user can check it after KeyPad_add
+ */
+uint8_t KeyPadShiftReg_getInvalidPins(void) {
+    return srInvalidPins;
+}
+
+static void KeyPadShiftReg_initPin(const KeyPad_PinConfig* config, KeyPad_PinMode mode) {
+    // shift registers have fixed direction, pull-up or pull-down must be external
+    uint8_t bits = mode == KeyPad_PinMode_Output ? srOutBits : srInBits;
+    if (mode != KeyPad_PinMode_Output) {
+        srInIdle = mode == KeyPad_PinMode_InputPullDown ? 0 : 1;
+    }
+    if (config->Pin >= bits && srInvalidPins < 0xFF) {
+        srInvalidPins++;
+    }
+}
+/**
+ * @brief read an input, all inputs shift in one transaction and next pins read from it
+ * chain shift again when a pin read twice or an output changed
+ */
+static uint8_t KeyPadShiftReg_readPin(const KeyPad_PinConfig* config) {
+    if (srInRead & __bit(config->Pin)) {
+        KeyPadShiftReg_shiftIn();
+    }
+    srInRead |= __bit(config->Pin);
+    return __getBit(srIn, config->Pin);
+}
+static void KeyPadShiftReg_writePin(const KeyPad_PinConfig* config, uint8_t value) {
+    if (value) {
+        srOut |= __bit(config->Pin);
+    }
+    else {
+        srOut &= ~__bit(config->Pin);
+    }
+    KeyPadShiftReg_shiftOut();
+}
+#if KEYPAD_USE_PORT
+/**
+ * @brief read all inputs of keypad in one transaction
+ */
+static KeyPad_PortMask KeyPadShiftReg_readPort(const KeyPad_PinConfig* configs, KeyPad_LenType len) {
+    KeyPad_PortMask value = 0;
+    KeyPad_LenType index;
+    KeyPadShiftReg_shiftIn();
+    for (index = 0; index < len; index++) {
+        value |= (KeyPad_PortMask) __getBit(srIn, configs[index].Pin) << index;
+    }
+    srInRead = ~(KeyPadShiftReg_Word) 0;
+    return value;
+}
+/**
+ * @brief write all outputs of keypad in one transaction, other bits of chain not changed
+ */
+static void KeyPadShiftReg_writePort(const KeyPad_PinConfig* configs, KeyPad_LenType len, KeyPad_PortMask value) {
+    KeyPad_LenType index;
+    for (index = 0; index < len; index++) {
+        if ((value >> index) & 1) {
+            srOut |= __bit(configs[index].Pin);
+        }
+        else {
+            srOut &= ~__bit(configs[index].Pin);
+        }
+    }
+    KeyPadShiftReg_shiftOut();
+}
+#endif // KEYPAD_USE_PORT
+static void KeyPadShiftReg_shiftIn(void) {
+    srIn = srBus->shiftIn(srInBits);
+    srInRead = 0;
+}
+static void KeyPadShiftReg_shiftOut(void) {
+    srBus->shiftOut(srOut, srOutBits);
+    // inputs changed by new outputs
+    srInRead = ~(KeyPadShiftReg_Word) 0;
+}
@@ -0,0 +1,62 @@
+/**
+ * @file KeyPadShiftReg.h
+ * @author Ali Mirghasemi (ali.mirghasemi1376@gmail.com)
+ * @brief KeyPad_Driver for matrices that connect through shift registers
+ * outputs drive by 74HC595 chain and inputs read by 74HC165 chain
+ * @version 0.1.0
+ * @date 2026-10-17
+ * 
+ * @copyright Copyright (c) 2026
+ * 
+ */
+
+#ifndef _KEYPAD_SHIFT_REG_H_
+#define _KEYPAD_SHIFT_REG_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif 
+
+#include "KeyPad.h"
+
+/**
+ * @brief hold state of a chain, bit N is N-th parallel pin of chain
+ */
+typedef uint32_t KeyPadShiftReg_Word;
+/**
+ * @brief maximum number of bits of each chain
+ */
+#define KEYPADSR_MAX_BITS                   (sizeof(KeyPadShiftReg_Word) * 8)
+
+/**
+ * @brief serial functions of chains, user can implement them with spi or bit-bang
+ */
+typedef struct {
+    /**
+     * @brief shift bits of value into 595 chain, then latch them on outputs
+     * bit N of value must appear on N-th output of chain
+     */
+    void                    (*shiftOut)(KeyPadShiftReg_Word value, uint8_t bits);
+    /**
+     * @brief parallel load 165 chain, then shift bits out
+     * N-th input of chain must return in bit N
+     */
+    KeyPadShiftReg_Word     (*shiftIn)(uint8_t bits);
+} KeyPadShiftReg_Bus;
+
+/**
+ * @brief driver of shift registers, pass it to KeyPad_init
+ * Pin of KeyPad_PinConfig is bit of chain and IO of KeyPad_PinConfig ignored
+ * output pins are bits of 595 chain and input pins are bits of 165 chain
+ * pins out of their chain counted by KeyPadShiftReg_getInvalidPins, they never drive and read idle level of their pull
+ */
+extern const KeyPad_Driver KeyPadShiftReg_driver;
+
+void KeyPadShiftReg_init(const KeyPadShiftReg_Bus* bus, uint8_t outBits, uint8_t inBits);
+uint8_t KeyPadShiftReg_getInvalidPins(void);
+
+#ifdef __cplusplus
+};
+#endif
+
+#endif /* _KEYPAD_SHIFT_REG_H_ */
@@ -0,0 +1,312 @@
+/**
+ * @file KeyPadLinuxMockTest.c
+ * @author Ali Mirghasemi (ali.mirghasemi1376@gmail.com)
+ * @brief test of KeyPadLinux driver with a mock ioctl on lines of KeyPadSim, no gpio chip needed
+ * driver compiled in this file with KEYPADLINUX_IOCTL set to mock_ioctl, each line request is a pipe
+ * so close, poll and read of driver work on it
+ * build and run with make test in this directory
+ * @version 0.1.0
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#include "KeyPadSim.h"
+#include <signal.h>
+#include <stdio.h>
+
+static int mock_ioctl(int fd, unsigned long request, void* arg);
+
+#define KEYPADLINUX_IOCTL                   mock_ioctl
+#include "KeyPadLinux.c"
+
+#define TEST_SIZE                           4
+#define TEST_IN_LINE                        32
+#define TEST_MAX_FDS                        64
+#define TEST_CHIP                           "/dev/null"
+
+#define TEST_ASSERT(C)                      if (!(C)) { printf("failed %s:%d: %s\n", __FILE__, __LINE__, #C); testFailed++; }
+
+/**
+ * @brief a mocked line request, read end of pipe is fd of request
+ */
+typedef struct {
+    uint32_t                    Offsets[GPIO_V2_LINES_MAX];
+    uint32_t                    Len;
+    uint64_t                    Flags;
+    int                         Write;                      /**< write end of pipe, for push edge events */
+    uint8_t                     Used;
+} MockLines;
+
+/**
+ * @brief number of each ioctl
+ */
+typedef struct {
+    uint32_t                    GetLine;
+    uint32_t                    SetConfig;
+    uint32_t                    GetValues;
+    uint32_t                    SetValues;
+} MockCounters;
+
+static const KeyPad_PinConfig testOuts[TEST_SIZE] = {{0, 0}, {0, 1}, {0, 2}, {0, 3}};
+static const KeyPad_PinConfig testIns[TEST_SIZE] = {{0, TEST_IN_LINE}, {0, TEST_IN_LINE + 1}, {0, TEST_IN_LINE + 2}, {0, TEST_IN_LINE + 3}};
+static const KeyPad_KeyValue testMap[TEST_SIZE * TEST_SIZE] = {
+    '1', '2', '3', 'A', '4', '5', '6', 'B', '7', '8', '9', 'C', '*', '0', '#', 'D',
+};
+#if KEYPAD_MODE == KEYPAD_MODE_ROW_INPUT
+static const KeyPad_Config testConfig = {testMap, testOuts, testIns, TEST_SIZE, TEST_SIZE};
+#else
+static const KeyPad_Config testConfig = {testMap, testIns, testOuts, TEST_SIZE, TEST_SIZE};
+#endif
+
+static MockLines mockLines[TEST_MAX_FDS];
+static MockCounters mockCounters;
+static int mockFailErrno;                                   /**< errno of next GET_VALUES, 0 for success */
+static KeyPad testKeyPad;
+static KeyPad_KeyValue testPressed;
+static KeyPad_KeyValue testReleased;
+static uint32_t testFailed;
+
+static int mock_ioctl(int fd, unsigned long request, void* arg) {
+    MockLines* lines;
+    uint32_t index;
+    if (request == GPIO_V2_GET_LINE_IOCTL) {
+        struct gpio_v2_line_request* req = (struct gpio_v2_line_request*) arg;
+        int fds[2];
+        if (pipe(fds) < 0) {
+            return -1;
+        }
+        if (fds[0] >= TEST_MAX_FDS) {
+            close(fds[0]);
+            close(fds[1]);
+            errno = EMFILE;
+            return -1;
+        }
+        lines = &mockLines[fds[0]];
+        memcpy(lines->Offsets, req->offsets, sizeof(lines->Offsets));
+        lines->Len = req->num_lines;
+        lines->Flags = req->config.flags;
+        lines->Write = fds[1];
+        lines->Used = 1;
+        req->fd = fds[0];
+        mockCounters.GetLine++;
+        return 0;
+    }
+    if (fd < 0 || fd >= TEST_MAX_FDS || !mockLines[fd].Used) {
+        errno = EBADF;
+        return -1;
+    }
+    lines = &mockLines[fd];
+    switch (request) {
+        case GPIO_V2_LINE_SET_CONFIG_IOCTL: {
+            struct gpio_v2_line_config* config = (struct gpio_v2_line_config*) arg;
+            lines->Flags = config->flags;
+            if (config->num_attrs > 0 && config->attrs[0].attr.id == GPIO_V2_LINE_ATTR_ID_OUTPUT_VALUES) {
+                for (index = 0; index < lines->Len; index++) {
+                    if ((config->attrs[0].mask >> index) & 1) {
+                        KeyPadSim_setLine((KeyPad_Pin) lines->Offsets[index], (uint8_t) ((config->attrs[0].attr.values >> index) & 1));
+                    }
+                }
+            }
+            mockCounters.SetConfig++;
+            return 0;
+        }
+        case GPIO_V2_LINE_GET_VALUES_IOCTL: {
+            struct gpio_v2_line_values* values = (struct gpio_v2_line_values*) arg;
+            mockCounters.GetValues++;
+            if (mockFailErrno) {
+                errno = mockFailErrno;
+                mockFailErrno = 0;
+                return -1;
+            }
+            values->bits = 0;
+            for (index = 0; index < lines->Len; index++) {
+                if ((values->mask >> index) & 1) {
+                    values->bits |= (uint64_t) KeyPadSim_getLine((KeyPad_Pin) lines->Offsets[index]) << index;
+                }
+            }
+            return 0;
+        }
+        case GPIO_V2_LINE_SET_VALUES_IOCTL: {
+            struct gpio_v2_line_values* values = (struct gpio_v2_line_values*) arg;
+            if (!(lines->Flags & GPIO_V2_LINE_FLAG_OUTPUT)) {
+                errno = EPERM;
+                return -1;
+            }
+            for (index = 0; index < lines->Len; index++) {
+                if ((values->mask >> index) & 1) {
+                    KeyPadSim_setLine((KeyPad_Pin) lines->Offsets[index], (uint8_t) ((values->bits >> index) & 1));
+                }
+            }
+            mockCounters.SetValues++;
+            return 0;
+        }
+        default:
+            errno = EINVAL;
+            return -1;
+    }
+}
+/**
+ * @brief find mocked request of first line
+ */
+static MockLines* mock_find(uint32_t offset) {
+    uint8_t index;
+    for (index = 0; index < TEST_MAX_FDS; index++) {
+        if (mockLines[index].Used && mockLines[index].Offsets[0] == offset) {
+            return &mockLines[index];
+        }
+    }
+    return 0;
+}
+
+static KeyPad_HandleStatus test_onKey(KeyPad* keypad, KeyPad_KeyValue value, KeyPad_State state) {
+    (void) keypad;
+    if (state == KeyPad_State_Pressed) {
+        testPressed = value;
+    }
+    else if (state == KeyPad_State_Released) {
+        testReleased = value;
+    }
+    return KeyPad_NotHandled;
+}
+
+static void test_handle(uint32_t ticks) {
+    while (ticks-- > 0) {
+        KeyPad_handle();
+    }
+}
+/**
+ * @brief push an edge event on inputs if their edge enabled and wait for it, same as gpio irq of idle keypads
+ */
+static void test_edge(void) {
+#if KEYPAD_IDLE_WAKE
+    struct gpio_v2_line_event event;
+    MockLines* ins = mock_find(TEST_IN_LINE);
+    if (ins->Flags & __EDGES) {
+        memset(&event, 0, sizeof(event));
+        TEST_ASSERT(write(ins->Write, &event, sizeof(event)) == (ssize_t) sizeof(event));
+        TEST_ASSERT(KeyPadLinux_wait(10) == 1);
+    }
+#endif // KEYPAD_IDLE_WAKE
+}
+/**
+ * @brief press and release a key, return 1 if callbacks see its value
+ */
+static uint8_t test_key(KeyPad_Pin out, KeyPad_Pin in, KeyPad_KeyValue value) {
+    testPressed = 0;
+    testReleased = 0;
+    KeyPadSim_press(out, in);
+    test_edge();
+    test_handle(4);
+    KeyPadSim_release(out, in);
+    test_handle(4);
+    return testPressed == value && testReleased == value;
+}
+/**
+ * @brief request lines of config, each pin array is one request and stay input until KeyPad_add
+ */
+static void test_request(void) {
+    MockLines* outs;
+    MockLines* ins;
+    TEST_ASSERT(KeyPadLinux_requestConfig(TEST_CHIP, &testConfig) == 0);
+    TEST_ASSERT(mockCounters.GetLine == 2);
+    outs = mock_find(0);
+    ins = mock_find(TEST_IN_LINE);
+    TEST_ASSERT(outs != 0 && outs->Len == TEST_SIZE && outs->Flags == GPIO_V2_LINE_FLAG_INPUT);
+    TEST_ASSERT(ins != 0 && ins->Len == TEST_SIZE && ins->Flags == GPIO_V2_LINE_FLAG_INPUT);
+    // request need at least one line
+    TEST_ASSERT(KeyPadLinux_request(TEST_CHIP, testOuts, 0) == -EINVAL);
+}
+/**
+ * @brief KeyPad_add set outputs and pull of inputs with one SET_CONFIG for each request, then keys scan through ioctls
+ */
+static void test_scan(void) {
+    uint32_t getValues;
+    TEST_ASSERT(KeyPad_add(&testKeyPad, &testConfig));
+#if KEYPAD_SHARED_CALLBACKS
+#elif KEYPAD_MULTI_CALLBACK
+    KeyPad_onPressed(&testKeyPad, test_onKey);
+    KeyPad_onReleased(&testKeyPad, test_onKey);
+#else
+    KeyPad_onChange(&testKeyPad, test_onKey);
+#endif
+    TEST_ASSERT(mock_find(0)->Flags == GPIO_V2_LINE_FLAG_OUTPUT);
+    TEST_ASSERT(mock_find(TEST_IN_LINE)->Flags == (GPIO_V2_LINE_FLAG_INPUT | GPIO_V2_LINE_FLAG_BIAS_PULL_UP));
+    TEST_ASSERT(mockCounters.SetConfig == 2);
+    TEST_ASSERT(test_key(0, TEST_IN_LINE, testMap[0]));
+    TEST_ASSERT(test_key(2, TEST_IN_LINE + 1, testMap[1 * TEST_SIZE + 2]));
+    TEST_ASSERT(test_key(3, TEST_IN_LINE + 3, testMap[3 * TEST_SIZE + 3]));
+    TEST_ASSERT(KeyPadLinux_getError() == 0);
+    getValues = mockCounters.GetValues;
+    KeyPad_handle();
+#if KEYPAD_USE_PORT
+    // inputs of each strobe read with one GET_VALUES
+    TEST_ASSERT(mockCounters.GetValues - getValues <= TEST_SIZE);
+#else
+    TEST_ASSERT(mockCounters.GetValues - getValues <= TEST_SIZE * TEST_SIZE);
+#endif
+}
+/**
+ * @brief failed ioctl keep its errno until KeyPadLinux_getError
+ */
+static void test_error(void) {
+    mockFailErrno = EIO;
+    test_edge();
+    KeyPad_handle();
+    TEST_ASSERT(KeyPadLinux_getError() == -EIO);
+    TEST_ASSERT(KeyPadLinux_getError() == 0);
+    TEST_ASSERT(test_key(1, TEST_IN_LINE + 2, testMap[2 * TEST_SIZE + 1]));
+}
+#if KEYPAD_IDLE_WAKE
+/**
+ * @brief idle keypads enable edge of inputs, KeyPadLinux_wait return events of request and wake keypads
+ */
+static void test_wake(void) {
+    MockLines* ins = mock_find(TEST_IN_LINE);
+    uint32_t getValues;
+    test_handle(4);
+    TEST_ASSERT(KeyPad_isIdle());
+    // pull-up inputs are active low
+    TEST_ASSERT(ins->Flags & GPIO_V2_LINE_FLAG_EDGE_FALLING);
+    TEST_ASSERT(KeyPadLinux_wait(0) == 0);
+    // idle keypads skip scan
+    getValues = mockCounters.GetValues;
+    test_handle(4);
+    TEST_ASSERT(mockCounters.GetValues == getValues);
+    // edge wake keypads for a scan, they go idle again at end of it while no key pressed
+    test_edge();
+    KeyPad_handle();
+    TEST_ASSERT(mockCounters.GetValues != getValues);
+    TEST_ASSERT(test_key(0, TEST_IN_LINE + 3, testMap[3 * TEST_SIZE]));
+}
+#endif // KEYPAD_IDLE_WAKE
+/**
+ * @brief release close fd of requests, pins of released lines report ENOENT
+ */
+static void test_release(void) {
+    int outFd = mock_find(0)->Write;
+    KeyPad_remove(&testKeyPad);
+    KeyPadLinux_releaseAll();
+    TEST_ASSERT(linuxGroups[0].Configs == 0 && linuxGroups[1].Configs == 0);
+    TEST_ASSERT(write(outFd, "", 1) < 0 && errno == EPIPE);
+    KeyPadLinux_driver.readPin(&testIns[0]);
+    TEST_ASSERT(KeyPadLinux_getError() == -ENOENT);
+}
+
+int main(void) {
+    // write on pipe that its request released must fail instead of kill test
+    signal(SIGPIPE, SIG_IGN);
+    KeyPadSim_reset(KeyPad_ActiveState_Low);
+    KeyPad_init(&KeyPadLinux_driver);
+    test_request();
+    test_scan();
+    test_error();
+#if KEYPAD_IDLE_WAKE
+    test_wake();
+#endif
+    test_release();
+    printf("%s\n", testFailed ? "FAILED" : "passed");
+    return testFailed ? 1 : 0;
+}
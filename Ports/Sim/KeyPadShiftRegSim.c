@@ -0,0 +1,88 @@
+#include "KeyPadShiftRegSim.h"
+
+/* private variables */
+static KeyPad_Pin srsOutBase;
+static KeyPad_Pin srsInBase;
+static KeyPadShiftReg_Word srsOutShift;                     /**< shift stage of 595 chain */
+static KeyPadShiftReg_Word srsOutLatch;                     /**< storage stage of 595 chain, drive lines */
+static KeyPadShiftReg_Word srsInShift;                      /**< shift stage of 165 chain */
+static KeyPadShiftRegSim_Counters srsCounters;
+
+static void KeyPadShiftRegSim_shiftOut(KeyPadShiftReg_Word value, uint8_t bits);
+static KeyPadShiftReg_Word KeyPadShiftRegSim_shiftIn(uint8_t bits);
+
+const KeyPadShiftReg_Bus KeyPadShiftRegSim_bus = {
+    .shiftOut = KeyPadShiftRegSim_shiftOut,
+    .shiftIn = KeyPadShiftRegSim_shiftIn,
+};
+
+/**
+ * @brief connect chains to lines of KeyPadSim and clear registers
+ * N-th output of 595 chain drive line outBase + N
+ * N-th input of 165 chain read line inBase + N
+ */
+void KeyPadShiftRegSim_init(KeyPad_Pin outBase, KeyPad_Pin inBase) {
+    srsOutBase = outBase;
+    srsInBase = inBase;
+    srsOutShift = 0;
+    srsOutLatch = 0;
+    srsInShift = 0;
+    KeyPadShiftRegSim_resetCounters();
+}
+/**
+ * @brief return number of serial operations since last reset
+ */
+const KeyPadShiftRegSim_Counters* KeyPadShiftRegSim_getCounters(void) {
+    return &srsCounters;
+}
+void KeyPadShiftRegSim_resetCounters(void) {
+    srsCounters.ShiftOut = 0;
+    srsCounters.ShiftIn = 0;
+    srsCounters.Clocks = 0;
+}
+/**
+ * @brief shift value bit by bit MSB first, each clock move chain one stage forward
+ * then latch pulse copy shift stage to outputs
+ */
+static void KeyPadShiftRegSim_shiftOut(KeyPadShiftReg_Word value, uint8_t bits) {
+    uint8_t bit;
+    KeyPad_Pin line;
+    if (bits > KEYPADSR_MAX_BITS) {
+        bits = KEYPADSR_MAX_BITS;
+    }
+    bit = bits;
+    while (bit-- > 0) {
+        srsOutShift = (srsOutShift << 1) | ((value >> bit) & 1);
+        srsCounters.Clocks++;
+    }
+    // latch
+    srsOutLatch = srsOutShift;
+    for (line = 0; line < bits; line++) {
+        KeyPadSim_setLine(srsOutBase + line, (srsOutLatch >> line) & 1);
+    }
+    srsCounters.ShiftOut++;
+}
+/**
+ * @brief parallel load inputs, then read serial output of last stage
+ * and clock chain for each bit, MSB first
+ */
+static KeyPadShiftReg_Word KeyPadShiftRegSim_shiftIn(uint8_t bits) {
+    KeyPadShiftReg_Word value = 0;
+    uint8_t bit;
+    if (bits > KEYPADSR_MAX_BITS) {
+        bits = KEYPADSR_MAX_BITS;
+    }
+    // load
+    srsInShift = 0;
+    for (bit = 0; bit < bits; bit++) {
+        srsInShift |= (KeyPadShiftReg_Word) KeyPadSim_getLine(srsInBase + bit) << bit;
+    }
+    bit = bits;
+    while (bit-- > 0) {
+        value |= ((srsInShift >> (bits - 1)) & 1) << bit;
+        srsInShift <<= 1;
+        srsCounters.Clocks++;
+    }
+    srsCounters.ShiftIn++;
+    return value;
+}
@@ -0,0 +1,46 @@
+/**
+ * @file KeyPadShiftRegSim.h
+ * @author Ali Mirghasemi (ali.mirghasemi1376@gmail.com)
+ * @brief simulated 74HC595 and 74HC165 chains for run KeyPadShiftReg driver on host
+ * chains connect to lines of KeyPadSim
+ * @version 0.1.0
+ * @date 2026-10-17
+ * 
+ * @copyright Copyright (c) 2026
+ * 
+ */
+
+#ifndef _KEYPAD_SHIFT_REG_SIM_H_
+#define _KEYPAD_SHIFT_REG_SIM_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif 
+
+#include "KeyPadSim.h"
+#include "KeyPadShiftReg.h"
+
+/**
+ * @brief number of serial operations of chains
+ */
+typedef struct {
+    uint32_t                    ShiftOut;                   /**< number of 595 transactions */
+    uint32_t                    ShiftIn;                    /**< number of 165 transactions */
+    uint32_t                    Clocks;                     /**< number of clock pulses on both chains */
+} KeyPadShiftRegSim_Counters;
+
+/**
+ * @brief simulated bus, pass it to KeyPadShiftReg_init
+ */
+extern const KeyPadShiftReg_Bus KeyPadShiftRegSim_bus;
+
+void KeyPadShiftRegSim_init(KeyPad_Pin outBase, KeyPad_Pin inBase);
+
+const KeyPadShiftRegSim_Counters* KeyPadShiftRegSim_getCounters(void);
+void KeyPadShiftRegSim_resetCounters(void);
+
+#ifdef __cplusplus
+};
+#endif
+
+#endif /* _KEYPAD_SHIFT_REG_SIM_H_ */
@@ -0,0 +1,141 @@
+/**
+ * @file KeyPadShiftRegSimTest.c
+ * @author Ali Mirghasemi (ali.mirghasemi1376@gmail.com)
+ * @brief test of KeyPadShiftReg driver on KeyPadShiftRegSim chains, a 4x4 matrix on 595 and 165 chains
+ * check decoded keys and number of ShiftOut and ShiftIn transactions of each scan, in pin and port mode
+ * build and run with make test in this directory
+ * @version 0.1.0
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "KeyPadShiftRegSim.h"
+#include <stdio.h>
+
+#if KEYPAD_DEBOUNCE || KEYPAD_NKRO
+    #error "KeyPadShiftRegSimTest count transactions of single key scan without debounce"
+#endif
+
+#define TEST_SIZE                           4
+#define TEST_OUT_BASE                       0
+#define TEST_IN_BASE                        16
+#define TEST_CHAIN_BITS                     8
+#define TEST_TICKS                          4
+
+#define TEST_ASSERT(C)                      if (!(C)) { printf("failed %s:%d: %s\n", __FILE__, __LINE__, #C); testFailed++; }
+
+// transactions of a full scan of idle matrix and of scan that stop at pressed key of an output
+#if KEYPAD_USE_PORT
+    // a port write strobe each output and release previous one, end of scan release last output, inputs read with a port read
+    #define TEST_IDLE_SHIFT_OUT             (TEST_SIZE + 1)
+    #define TEST_PRESS_SHIFT_OUT(OUT)       ((OUT) + 1)
+#else
+    // each output strobe and release with a pin write
+    #define TEST_IDLE_SHIFT_OUT             (2 * TEST_SIZE)
+    #define TEST_PRESS_SHIFT_OUT(OUT)       (2 * (OUT) + 1)
+#endif
+// first read of inputs of an output shift chain and next reads use it
+#define TEST_IDLE_SHIFT_IN                  TEST_SIZE
+#define TEST_PRESS_SHIFT_IN(OUT)            ((OUT) + 1)
+// held key read only its input while its output stay active
+#define TEST_HELD_SHIFT_OUT                 0
+#define TEST_HELD_SHIFT_IN                  1
+
+static const KeyPad_PinConfig testOuts[TEST_SIZE] = {{0, 0}, {0, 1}, {0, 2}, {0, 3}};
+static const KeyPad_PinConfig testIns[TEST_SIZE] = {{0, 0}, {0, 1}, {0, 2}, {0, 3}};
+static const KeyPad_KeyValue testMap[TEST_SIZE * TEST_SIZE] = {
+    '1', '2', '3', 'A',
+    '4', '5', '6', 'B',
+    '7', '8', '9', 'C',
+    '*', '0', '#', 'D',
+};
+#if KEYPAD_MODE == KEYPAD_MODE_ROW_INPUT
+static const KeyPad_Config testConfig = {testMap, testOuts, testIns, TEST_SIZE, TEST_SIZE};
+    #define TEST_KEY(OUT, IN)               testMap[(IN) * TEST_SIZE + (OUT)]
+#else
+static const KeyPad_Config testConfig = {testMap, testIns, testOuts, TEST_SIZE, TEST_SIZE};
+    #define TEST_KEY(OUT, IN)               testMap[(OUT) * TEST_SIZE + (IN)]
+#endif
+
+static KeyPad testKeyPad;
+static KeyPad_KeyValue testPressed;
+static KeyPad_KeyValue testReleased;
+static uint32_t testFailed;
+
+static KeyPad_HandleStatus test_onKey(KeyPad* keypad, KeyPad_KeyValue value, KeyPad_State state) {
+    (void) keypad;
+    if (state == KeyPad_State_Pressed) {
+        testPressed = value;
+    }
+    else if (state == KeyPad_State_Released) {
+        testReleased = value;
+    }
+    return KeyPad_NotHandled;
+}
+/**
+ * @brief run a tick and check transactions of chains in it
+ */
+static void test_tick(uint32_t shiftOut, uint32_t shiftIn) {
+    KeyPadShiftRegSim_resetCounters();
+    KeyPad_handle();
+    TEST_ASSERT(KeyPadShiftRegSim_getCounters()->ShiftOut == shiftOut);
+    TEST_ASSERT(KeyPadShiftRegSim_getCounters()->ShiftIn == shiftIn);
+    if (KeyPadShiftRegSim_getCounters()->ShiftOut != shiftOut || KeyPadShiftRegSim_getCounters()->ShiftIn != shiftIn) {
+        printf("shiftOut %u, shiftIn %u\n", (unsigned) KeyPadShiftRegSim_getCounters()->ShiftOut,
+               (unsigned) KeyPadShiftRegSim_getCounters()->ShiftIn);
+    }
+}
+/**
+ * @brief press each key of matrix, check decoded value and transactions of press, hold and release
+ */
+static void test_keys(void) {
+    KeyPad_LenType out;
+    KeyPad_LenType in;
+    uint8_t tick;
+    for (out = 0; out < TEST_SIZE; out++) {
+        for (in = 0; in < TEST_SIZE; in++) {
+            testPressed = 0;
+            testReleased = 0;
+            KeyPadSim_press(TEST_OUT_BASE + out, TEST_IN_BASE + in);
+            // scan stop at output of pressed key and keep it active
+            test_tick(TEST_PRESS_SHIFT_OUT(out), TEST_PRESS_SHIFT_IN(out));
+            TEST_ASSERT(testPressed == TEST_KEY(out, in));
+            for (tick = 0; tick < TEST_TICKS; tick++) {
+                test_tick(TEST_HELD_SHIFT_OUT, TEST_HELD_SHIFT_IN);
+            }
+            KeyPadSim_release(TEST_OUT_BASE + out, TEST_IN_BASE + in);
+            // check of key find it released and release its output
+            test_tick(1, 1);
+            TEST_ASSERT(testReleased == TEST_KEY(out, in));
+            // back to full scan
+            test_tick(TEST_IDLE_SHIFT_OUT, TEST_IDLE_SHIFT_IN);
+        }
+    }
+}
+
+int main(void) {
+    uint8_t tick;
+    KeyPadSim_reset(KeyPad_ActiveState_Low);
+    KeyPadShiftRegSim_init(TEST_OUT_BASE, TEST_IN_BASE);
+    KeyPadShiftReg_init(&KeyPadShiftRegSim_bus, TEST_CHAIN_BITS, TEST_CHAIN_BITS);
+    KeyPad_init(&KeyPadShiftReg_driver);
+    TEST_ASSERT(KeyPad_add(&testKeyPad, &testConfig));
+    TEST_ASSERT(KeyPadShiftReg_getInvalidPins() == 0);
+#if KEYPAD_MULTI_CALLBACK
+    KeyPad_onPressed(&testKeyPad, test_onKey);
+    KeyPad_onReleased(&testKeyPad, test_onKey);
+#else
+    KeyPad_onChange(&testKeyPad, test_onKey);
+#endif
+
+    for (tick = 0; tick < TEST_TICKS; tick++) {
+        test_tick(TEST_IDLE_SHIFT_OUT, TEST_IDLE_SHIFT_IN);
+    }
+    TEST_ASSERT(testPressed == 0);
+    test_keys();
+
+    printf("%s\n", testFailed ? "FAILED" : "passed");
+    return testFailed ? 1 : 0;
+}
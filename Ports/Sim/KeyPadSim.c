@@ -0,0 +1,310 @@
+#define _POSIX_C_SOURCE 199309L
+#include "KeyPadSim.h"
+#include <time.h>
+
+#define __lineBit(L)                    ((uint64_t) 1 << (L))
+#define __isLine(L)                     ((L) < KEYPADSIM_MAX_LINES)
+
+#if KEYPAD_CONCURRENT
+    // KeyPad_add and KeyPad_remove init and deinit pins in other context while KeyPad_handle drive lines, like registers of gpio
+    #define __load(X)                   __atomic_load_n(&(X), __ATOMIC_RELAXED)
+    #define __set(X, BITS)              __atomic_fetch_or(&(X), (BITS), __ATOMIC_RELAXED)
+    #define __clear(X, BITS)            __atomic_fetch_and(&(X), ~(BITS), __ATOMIC_RELAXED)
+    #define __inc(X)                    __atomic_fetch_add(&(X), 1, __ATOMIC_RELAXED)
+    #define __dec(X)                    __atomic_fetch_sub(&(X), 1, __ATOMIC_RELAXED)
+#else
+    #define __load(X)                   (X)
+    #define __set(X, BITS)              (X) |= (BITS)
+    #define __clear(X, BITS)            (X) &= ~(BITS)
+    #define __inc(X)                    (X)++
+    #define __dec(X)                    (X)--
+#endif // KEYPAD_CONCURRENT
+
+/* private variables */
+static uint64_t simLinks[KEYPADSIM_MAX_LINES];              /**< outputs that connected to each input by pressed keys */
+static uint64_t simActiveOuts;                              /**< outputs that drive in active state */
+static uint64_t simWakeIns;                                 /**< inputs that wake enabled on them */
+static uint16_t simInits[KEYPADSIM_MAX_LINES];              /**< keypads that init each line and not deinit it yet */
+static uint8_t simActiveState;
+static const KeyPadSim_Step* simScript;
+static uint32_t simScriptLen;
+static uint32_t simTick;
+static KeyPadSim_Counters simCounters;
+
+static void KeyPadSim_initPin(const KeyPad_PinConfig* config, KeyPad_PinMode mode);
+#if KEYPAD_USE_DEINIT
+static void KeyPadSim_deinitPin(const KeyPad_PinConfig* config);
+#endif // KEYPAD_USE_DEINIT
+static uint8_t KeyPadSim_readPin(const KeyPad_PinConfig* config);
+static void KeyPadSim_writePin(const KeyPad_PinConfig* config, uint8_t value);
+#if KEYPAD_USE_PORT
+static KeyPad_PortMask KeyPadSim_readPort(const KeyPad_PinConfig* configs, KeyPad_LenType len);
+static void KeyPadSim_writePort(const KeyPad_PinConfig* configs, KeyPad_LenType len, KeyPad_PortMask value);
+#endif // KEYPAD_USE_PORT
+#if KEYPAD_IDLE_WAKE
+static void KeyPadSim_setWakePin(const KeyPad_PinConfig* config, uint8_t enable);
+#endif // KEYPAD_IDLE_WAKE
+static uint8_t KeyPadSim_read(KeyPad_Pin line);
+static void KeyPadSim_write(KeyPad_Pin line, uint8_t value);
+static void KeyPadSim_checkWake(void);
+static void KeyPadSim_checkInit(KeyPad_Pin line, uint8_t use);
+
+const KeyPad_Driver KeyPadSim_driver = {
+    .initPin = KeyPadSim_initPin,
+    .readPin = KeyPadSim_readPin,
+    .writePin = KeyPadSim_writePin,
+#if KEYPAD_USE_DEINIT
+    .deinitPin = KeyPadSim_deinitPin,
+#endif
+#if KEYPAD_USE_PORT
+    .readPort = KeyPadSim_readPort,
+    .writePort = KeyPadSim_writePort,
+#endif
+#if KEYPAD_IDLE_WAKE
+    .setWakePin = KeyPadSim_setWakePin,
+#endif
+};
+
+const KeyPad_Driver KeyPadSim_pinDriver = {
+    .initPin = KeyPadSim_initPin,
+    .readPin = KeyPadSim_readPin,
+    .writePin = KeyPadSim_writePin,
+#if KEYPAD_USE_DEINIT
+    .deinitPin = KeyPadSim_deinitPin,
+#endif
+#if KEYPAD_IDLE_WAKE
+    .setWakePin = KeyPadSim_setWakePin,
+#endif
+};
+
+/**
+ * @brief release all keys and lines, clear script and counters
+ * init state of lines not changed, it belong to added keypads
+ * 
+ * @param state active state of simulated keypads
+ */
+void KeyPadSim_reset(KeyPad_ActiveState state) {
+    KeyPad_Pin line;
+    for (line = 0; line < KEYPADSIM_MAX_LINES; line++) {
+        simLinks[line] = 0;
+    }
+    simActiveOuts = 0;
+    simWakeIns = 0;
+    simActiveState = (uint8_t) state;
+    simScript = 0;
+    simScriptLen = 0;
+    simTick = 0;
+    KeyPadSim_resetCounters();
+}
+/**
+ * @brief press key that connect output line to input line
+ */
+void KeyPadSim_press(KeyPad_Pin out, KeyPad_Pin in) {
+    if (__isLine(out) && __isLine(in)) {
+        __set(simLinks[in], __lineBit(out));
+        KeyPadSim_checkWake();
+    }
+}
+/**
+ * @brief release key that connect output line to input line
+ */
+void KeyPadSim_release(KeyPad_Pin out, KeyPad_Pin in) {
+    if (__isLine(out) && __isLine(in)) {
+        __clear(simLinks[in], __lineBit(out));
+    }
+}
+/**
+ * @brief return level of line, same as readPin without count it
+ */
+uint8_t KeyPadSim_getLine(KeyPad_Pin line) {
+    return KeyPadSim_read(line);
+}
+/**
+ * @brief drive line, same as writePin without count it
+ * external drivers like shift register chains use it
+ */
+void KeyPadSim_setLine(KeyPad_Pin line, uint8_t value) {
+    KeyPadSim_write(line, value);
+}
+/**
+ * @brief set key press script, steps must sort by tick
+ * KeyPadSim_step apply steps
+ */
+void KeyPadSim_setScript(const KeyPadSim_Step* steps, uint32_t len) {
+    simScript = steps;
+    simScriptLen = len;
+}
+/**
+ * @brief apply steps of current tick and go to next tick
+ * user must call it before each KeyPad_handle
+ */
+void KeyPadSim_step(void) {
+    while (simScriptLen > 0 && simScript->Tick <= simTick) {
+        if (simScript->Pressed) {
+            KeyPadSim_press(simScript->Out, simScript->In);
+        }
+        else {
+            KeyPadSim_release(simScript->Out, simScript->In);
+        }
+        simScript++;
+        simScriptLen--;
+    }
+    simTick++;
+}
+/**
+ * @brief return number of KeyPadSim_step calls
+ */
+uint32_t KeyPadSim_getTick(void) {
+    return simTick;
+}
+/**
+ * @brief return number of driver function calls since last reset
+ */
+const KeyPadSim_Counters* KeyPadSim_getCounters(void) {
+    return &simCounters;
+}
+void KeyPadSim_resetCounters(void) {
+    simCounters.InitPin = 0;
+    simCounters.ReadPin = 0;
+    simCounters.WritePin = 0;
+    simCounters.ReadPort = 0;
+    simCounters.WritePort = 0;
+    simCounters.SetWakePin = 0;
+    simCounters.DeinitAccess = 0;
+}
+/**
+ * @brief run KeyPadSim_step and KeyPad_handle for number of ticks and measure them
+ * keypads must add and script must set before
+ * 
+ * @param ticks number of KeyPad_handle calls
+ * @param result time and driver calls per tick
+ */
+void KeyPadSim_bench(uint32_t ticks, KeyPadSim_Bench* result) {
+    struct timespec start;
+    struct timespec end;
+    uint32_t count = ticks;
+    double ns;
+
+    KeyPadSim_resetCounters();
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    while (count-- > 0) {
+        KeyPadSim_step();
+        KeyPad_handle();
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    ns = (double) (end.tv_sec - start.tv_sec) * 1e9 + (double) (end.tv_nsec - start.tv_nsec);
+
+    result->Ticks = ticks;
+    result->NsPerHandle = ticks ? ns / ticks : 0;
+    result->ReadsPerTick = ticks ? (double) (simCounters.ReadPin + simCounters.ReadPort) / ticks : 0;
+    result->WritesPerTick = ticks ? (double) (simCounters.WritePin + simCounters.WritePort) / ticks : 0;
+}
+
+static void KeyPadSim_initPin(const KeyPad_PinConfig* config, KeyPad_PinMode mode) {
+    (void) mode;
+    __inc(simCounters.InitPin);
+    if (__isLine(config->Pin)) {
+        __inc(simInits[config->Pin]);
+    }
+}
+#if KEYPAD_USE_DEINIT
+static void KeyPadSim_deinitPin(const KeyPad_PinConfig* config) {
+    if (__isLine(config->Pin) && __load(simInits[config->Pin]) > 0) {
+        __dec(simInits[config->Pin]);
+    }
+}
+#endif // KEYPAD_USE_DEINIT
+static uint8_t KeyPadSim_readPin(const KeyPad_PinConfig* config) {
+    __inc(simCounters.ReadPin);
+    KeyPadSim_checkInit(config->Pin, 1);
+    return KeyPadSim_read(config->Pin);
+}
+static void KeyPadSim_writePin(const KeyPad_PinConfig* config, uint8_t value) {
+    __inc(simCounters.WritePin);
+    KeyPadSim_checkInit(config->Pin, value == simActiveState);
+    KeyPadSim_write(config->Pin, value);
+}
+#if KEYPAD_USE_PORT
+static KeyPad_PortMask KeyPadSim_readPort(const KeyPad_PinConfig* configs, KeyPad_LenType len) {
+    KeyPad_PortMask value = 0;
+    KeyPad_LenType index;
+    __inc(simCounters.ReadPort);
+    for (index = 0; index < len; index++) {
+        KeyPadSim_checkInit(configs[index].Pin, 1);
+        value |= (KeyPad_PortMask) KeyPadSim_read(configs[index].Pin) << index;
+    }
+    return value;
+}
+static void KeyPadSim_writePort(const KeyPad_PinConfig* configs, KeyPad_LenType len, KeyPad_PortMask value) {
+    KeyPad_LenType index;
+    __inc(simCounters.WritePort);
+    for (index = 0; index < len; index++) {
+        KeyPadSim_checkInit(configs[index].Pin, ((value >> index) & 1) == simActiveState);
+        KeyPadSim_write(configs[index].Pin, (value >> index) & 1);
+    }
+}
+#endif // KEYPAD_USE_PORT
+#if KEYPAD_IDLE_WAKE
+static void KeyPadSim_setWakePin(const KeyPad_PinConfig* config, uint8_t enable) {
+    __inc(simCounters.SetWakePin);
+    if (__isLine(config->Pin)) {
+        if (enable) {
+            __set(simWakeIns, __lineBit(config->Pin));
+        }
+        else {
+            __clear(simWakeIns, __lineBit(config->Pin));
+        }
+    }
+}
+#endif // KEYPAD_IDLE_WAKE
+/**
+ * @brief input is active if a pressed key connect it to an active output
+ */
+static uint8_t KeyPadSim_read(KeyPad_Pin line) {
+    if (__isLine(line) && (__load(simLinks[line]) & __load(simActiveOuts))) {
+        return simActiveState;
+    }
+    return !simActiveState;
+}
+static void KeyPadSim_write(KeyPad_Pin line, uint8_t value) {
+    if (__isLine(line)) {
+        if (value == simActiveState) {
+            __set(simActiveOuts, __lineBit(line));
+            KeyPadSim_checkWake();
+        }
+        else {
+            __clear(simActiveOuts, __lineBit(line));
+        }
+    }
+}
+/**
+ * @brief simulate edge interrupt of inputs that wake enabled on them
+ */
+static void KeyPadSim_checkWake(void) {
+#if KEYPAD_IDLE_WAKE
+    uint64_t ins = __load(simWakeIns);
+    KeyPad_Pin line = 0;
+    while (ins) {
+        if ((ins & 1) && (__load(simLinks[line]) & __load(simActiveOuts))) {
+            KeyPad_wake();
+            return;
+        }
+        ins >>= 1;
+        line++;
+    }
+#endif // KEYPAD_IDLE_WAKE
+}
+/**
+ * @brief count read or active write of a line that no keypad init it, ex: pins of removed keypad after deinit
+ * inactive write is allowed, KeyPad_add write level of outputs before init them
+ */
+static void KeyPadSim_checkInit(KeyPad_Pin line, uint8_t use) {
+#if KEYPAD_USE_DEINIT
+    if (use && __isLine(line) && __load(simInits[line]) == 0) {
+        __inc(simCounters.DeinitAccess);
+    }
+#else
+    (void) line;
+    (void) use;
+#endif // KEYPAD_USE_DEINIT
+}
@@ -0,0 +1,95 @@
+/**
+ * @file KeyPadSim.h
+ * @author Ali Mirghasemi (ali.mirghasemi1376@gmail.com)
+ * @brief simulated KeyPad_Driver for run and measure KeyPad library on host
+ * @version 0.1.0
+ * @date 2026-10-17
+ * 
+ * @copyright Copyright (c) 2026
+ * 
+ */
+
+#ifndef _KEYPAD_SIM_H_
+#define _KEYPAD_SIM_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif 
+
+#include "KeyPad.h"
+
+/******************************************************************************/
+/*                                Configuration                               */
+/******************************************************************************/
+
+/**
+ * @brief maximum number of simulated lines, must be 64 or less
+ * Pin of KeyPad_PinConfig is line number and IO of KeyPad_PinConfig ignored
+ */
+#define KEYPADSIM_MAX_LINES                 64
+
+/******************************************************************************/
+
+/**
+ * @brief a step of key press script
+ */
+typedef struct {
+    uint32_t                    Tick;                       /**< tick that step apply on it */
+    KeyPad_Pin                  Out;                        /**< output line of key */
+    KeyPad_Pin                  In;                         /**< input line of key */
+    uint8_t                     Pressed;                    /**< 1 for press key, 0 for release key */
+} KeyPadSim_Step;
+
+/**
+ * @brief number of driver function calls
+ */
+typedef struct {
+    uint32_t                    InitPin;
+    uint32_t                    ReadPin;
+    uint32_t                    WritePin;
+    uint32_t                    ReadPort;
+    uint32_t                    WritePort;
+    uint32_t                    SetWakePin;
+    uint32_t                    DeinitAccess;               /**< reads and active writes of lines that not init or deinit, only with KEYPAD_USE_DEINIT */
+} KeyPadSim_Counters;
+
+/**
+ * @brief result of KeyPadSim_bench
+ */
+typedef struct {
+    uint32_t                    Ticks;                      /**< number of KeyPad_handle calls */
+    double                      NsPerHandle;                /**< average time of KeyPad_handle in nano seconds */
+    double                      ReadsPerTick;               /**< average readPin and readPort calls per tick */
+    double                      WritesPerTick;              /**< average writePin and writePort calls per tick */
+} KeyPadSim_Bench;
+
+/**
+ * @brief simulated driver, pass it to KeyPad_init
+ */
+extern const KeyPad_Driver KeyPadSim_driver;
+/**
+ * @brief same as KeyPadSim_driver but readPort and writePort are null
+ */
+extern const KeyPad_Driver KeyPadSim_pinDriver;
+
+void KeyPadSim_reset(KeyPad_ActiveState state);
+
+void KeyPadSim_press(KeyPad_Pin out, KeyPad_Pin in);
+void KeyPadSim_release(KeyPad_Pin out, KeyPad_Pin in);
+uint8_t KeyPadSim_getLine(KeyPad_Pin line);
+void KeyPadSim_setLine(KeyPad_Pin line, uint8_t value);
+
+void KeyPadSim_setScript(const KeyPadSim_Step* steps, uint32_t len);
+void KeyPadSim_step(void);
+uint32_t KeyPadSim_getTick(void);
+
+const KeyPadSim_Counters* KeyPadSim_getCounters(void);
+void KeyPadSim_resetCounters(void);
+
+void KeyPadSim_bench(uint32_t ticks, KeyPadSim_Bench* result);
+
+#ifdef __cplusplus
+};
+#endif
+
+#endif /* _KEYPAD_SIM_H_ */
@@ -0,0 +1,103 @@
+/**
+ * @file KeyPadSimBench.c
+ * @author Ali Mirghasemi (ali.mirghasemi1376@gmail.com)
+ * @brief benchmark of KeyPad_handle on simulated driver, print ns per handle for matrix sizes and keypad counts
+ * build and run with make bench in this directory
+ * @version 0.1.0
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "KeyPadSim.h"
+#include <stdio.h>
+
+#define BENCH_TICKS                         100000
+#define BENCH_PRESS_PERIOD                  1000
+#define BENCH_PRESS_TICKS                   200
+#define BENCH_MAX_SIZE                      16
+#define BENCH_MAX_KEYPADS                   64
+#define BENCH_IN_LINE                       32
+
+static const uint8_t benchSizes[] = {4, 8, 16};
+static const uint8_t benchKeyPads[] = {1, 8, 64};
+
+static KeyPad_PinConfig benchOuts[BENCH_MAX_SIZE];
+static KeyPad_PinConfig benchIns[BENCH_MAX_SIZE];
+static KeyPad_KeyValue benchMap[BENCH_MAX_SIZE * BENCH_MAX_SIZE];
+static KeyPad benchKeyPad[BENCH_MAX_KEYPADS];
+static KeyPadSim_Step benchScript[BENCH_TICKS / BENCH_PRESS_PERIOD * 2];
+
+/**
+ * @brief a key press each BENCH_PRESS_PERIOD ticks, walk on diagonal of matrix
+ */
+static uint32_t bench_makeScript(uint8_t size) {
+    uint32_t len = 0;
+    uint32_t tick;
+    for (tick = BENCH_PRESS_PERIOD; tick + BENCH_PRESS_TICKS < BENCH_TICKS; tick += BENCH_PRESS_PERIOD) {
+        KeyPad_Pin line = (KeyPad_Pin) ((tick / BENCH_PRESS_PERIOD) % size);
+        benchScript[len++] = (KeyPadSim_Step) {tick, line, (KeyPad_Pin) (BENCH_IN_LINE + line), 1};
+        benchScript[len++] = (KeyPadSim_Step) {tick + BENCH_PRESS_TICKS, line, (KeyPad_Pin) (BENCH_IN_LINE + line), 0};
+    }
+    return len;
+}
+
+static KeyPad_HandleStatus bench_onKey(KeyPad* keypad, KeyPad_KeyValue value, KeyPad_State state) {
+    (void) keypad;
+    (void) value;
+    (void) state;
+    return KeyPad_NotHandled;
+}
+
+int main(void) {
+    uint8_t index;
+    uint8_t sizeIndex;
+    uint8_t countIndex;
+    KeyPadSim_Bench result;
+
+    for (index = 0; index < BENCH_MAX_SIZE; index++) {
+        benchOuts[index].Pin = index;
+        benchIns[index].Pin = (KeyPad_Pin) (BENCH_IN_LINE + index);
+    }
+    KeyPad_init(&KeyPadSim_driver);
+    printf("%-8s %-8s %-12s %-12s %-12s\n", "matrix", "keypads", "ns/handle", "reads/tick", "writes/tick");
+    for (sizeIndex = 0; sizeIndex < sizeof(benchSizes); sizeIndex++) {
+        uint8_t size = benchSizes[sizeIndex];
+    #if KEYPAD_MODE == KEYPAD_MODE_ROW_INPUT
+        KeyPad_Config config = {benchMap, benchOuts, benchIns, (KeyPad_LenType) size, (KeyPad_LenType) size};
+    #else
+        KeyPad_Config config = {benchMap, benchIns, benchOuts, (KeyPad_LenType) size, (KeyPad_LenType) size};
+    #endif
+        for (countIndex = 0; countIndex < sizeof(benchKeyPads); countIndex++) {
+            uint8_t count = benchKeyPads[countIndex];
+            uint8_t added = 0;
+            KeyPadSim_reset(KeyPad_ActiveState_Low);
+            KeyPadSim_setScript(benchScript, bench_makeScript(size));
+            for (index = 0; index < count; index++) {
+                if (KeyPad_add(&benchKeyPad[index], &config)) {
+                    added++;
+                #if KEYPAD_SHARED_CALLBACKS
+                #elif KEYPAD_MULTI_CALLBACK
+                    KeyPad_onPressed(&benchKeyPad[index], bench_onKey);
+                    KeyPad_onReleased(&benchKeyPad[index], bench_onKey);
+                #else
+                    KeyPad_onChange(&benchKeyPad[index], bench_onKey);
+                #endif
+                }
+            }
+            if (added == count) {
+                KeyPadSim_bench(BENCH_TICKS, &result);
+                printf("%2ux%-5u %-8u %-12.1f %-12.2f %-12.2f\n", size, size, count,
+                       result.NsPerHandle, result.ReadsPerTick, result.WritesPerTick);
+            }
+            else {
+                printf("%2ux%-5u %-8u not supported by config of library\n", size, size, count);
+            }
+            for (index = 0; index < added; index++) {
+                KeyPad_remove(&benchKeyPad[index]);
+            }
+        }
+    }
+    return 0;
+}
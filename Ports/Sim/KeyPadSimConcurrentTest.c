@@ -0,0 +1,339 @@
+/**
+ * @file KeyPadSimConcurrentTest.c
+ * @author Ali Mirghasemi (ali.mirghasemi1376@gmail.com)
+ * @brief test of KEYPAD_CONCURRENT on simulated driver, KeyPad_handle run in a thread
+ * while main thread add, remove and set config of keypads
+ * build and run with make test in this directory
+ * @version 0.1.0
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "KeyPadSim.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+
+#if !KEYPAD_CONCURRENT
+    #error "KeyPadSimConcurrentTest need KEYPAD_CONCURRENT"
+#endif
+
+#define TEST_KEYPADS                        8
+#define TEST_SIZE                           4
+#define TEST_IN_LINE                        32
+#define TEST_OWN_LINE                       8
+#define TEST_PRESS_PERIOD                   16
+#define TEST_PRESS_TICKS                    8
+#ifndef TEST_STRESS_STEPS
+    // thread sanitizer build run less steps and events
+    #define TEST_STRESS_STEPS               200000
+#endif
+#ifndef TEST_STRESS_EVENTS
+    #define TEST_STRESS_EVENTS              1000
+#endif
+
+// variables that main thread and handle thread share, each has one writer
+#define TEST_LOAD(X)                        KEYPAD_LOAD_ACQUIRE(X)
+#define TEST_STORE(X, V)                    KEYPAD_STORE_RELEASE(X, V)
+
+#define TEST_ASSERT(C)                      if (!(C)) { printf("failed %s:%d: %s\n", __FILE__, __LINE__, #C); testFailed++; }
+
+static const KeyPad_PinConfig testOuts[TEST_SIZE] = {{0, 0}, {0, 1}, {0, 2}, {0, 3}};
+static const KeyPad_PinConfig testIns[TEST_SIZE] = {{0, TEST_IN_LINE}, {0, TEST_IN_LINE + 1}, {0, TEST_IN_LINE + 2}, {0, TEST_IN_LINE + 3}};
+static const KeyPad_PinConfig testOwnOuts[TEST_SIZE] = {{0, TEST_OWN_LINE}, {0, TEST_OWN_LINE + 1}, {0, TEST_OWN_LINE + 2}, {0, TEST_OWN_LINE + 3}};
+static const KeyPad_PinConfig testOwnIns[TEST_SIZE] = {{0, TEST_IN_LINE + TEST_OWN_LINE}, {0, TEST_IN_LINE + TEST_OWN_LINE + 1},
+                                                       {0, TEST_IN_LINE + TEST_OWN_LINE + 2}, {0, TEST_IN_LINE + TEST_OWN_LINE + 3}};
+static const KeyPad_KeyValue testMapA[TEST_SIZE * TEST_SIZE] = {
+    'a', 'b', 'c', 'd', 'e', 'f', 'g', 'h', 'i', 'j', 'k', 'l', 'm', 'n', 'o', 'p',
+};
+static const KeyPad_KeyValue testMapB[TEST_SIZE * TEST_SIZE] = {
+    'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H', 'I', 'J', 'K', 'L', 'M', 'N', 'O', 'P',
+};
+#if KEYPAD_MODE == KEYPAD_MODE_ROW_INPUT
+static const KeyPad_Config testConfigA = {testMapA, testOuts, testIns, TEST_SIZE, TEST_SIZE};
+static const KeyPad_Config testConfigB = {testMapB, testOuts, testIns, TEST_SIZE, TEST_SIZE};
+static const KeyPad_Config testConfigOwn = {testMapA, testOwnOuts, testOwnIns, TEST_SIZE, TEST_SIZE};
+#else
+static const KeyPad_Config testConfigA = {testMapA, testIns, testOuts, TEST_SIZE, TEST_SIZE};
+static const KeyPad_Config testConfigB = {testMapB, testIns, testOuts, TEST_SIZE, TEST_SIZE};
+static const KeyPad_Config testConfigOwn = {testMapA, testOwnIns, testOwnOuts, TEST_SIZE, TEST_SIZE};
+#endif
+
+static KeyPad testKeyPad[TEST_KEYPADS];
+static KeyPad_KeyValue testPressed[TEST_KEYPADS];           /**< value of pressed key of each keypad, only handle change it */
+static uint32_t testRemoved;
+static uint8_t testGone[TEST_KEYPADS];                      /**< KeyPad_remove of keypad returned 1 */
+static uint32_t testGoneTick[TEST_KEYPADS];                 /**< handles that completed when remove returned */
+static uint32_t testTick;                                   /**< number of completed handles of handle thread */
+static uint32_t testLate;                                   /**< callbacks of keypads after their remove */
+static uint32_t testEvents;
+static uint32_t testFailed;
+static uint8_t testRunning;
+
+/**
+ * @brief check released key is same as pressed key, so config not changed while key is pressed
+ */
+static KeyPad_HandleStatus test_onKey(KeyPad* keypad, KeyPad_KeyValue value, KeyPad_State state) {
+    uint32_t index = (uint32_t) (keypad - testKeyPad);
+    // handle that started after remove returned must not fire, handle that was running maybe fire
+    if (TEST_LOAD(testGone[index]) && testTick > TEST_LOAD(testGoneTick[index])) {
+        testLate++;
+    }
+    if (state == KeyPad_State_Pressed) {
+        testPressed[index] = value;
+        TEST_STORE(testEvents, testEvents + 1);
+    }
+    else if (state == KeyPad_State_Released) {
+        TEST_ASSERT(testPressed[index] == value);
+        testPressed[index] = 0;
+    }
+    return KeyPad_NotHandled;
+}
+/**
+ * @brief last keypad, that scan first, remove all other keypads in its callback
+ * removed keypads must not fire in rest of handle
+ */
+static KeyPad_HandleStatus test_onRemove(KeyPad* keypad, KeyPad_KeyValue value, KeyPad_State state) {
+    uint8_t index;
+    (void) value;
+    if (state != KeyPad_State_Pressed) {
+        return KeyPad_NotHandled;
+    }
+    if (keypad == &testKeyPad[TEST_KEYPADS - 1]) {
+        for (index = 0; index < TEST_KEYPADS - 1; index++) {
+            testGone[index] = KeyPad_remove(&testKeyPad[index]);
+            testRemoved += testGone[index];
+        }
+    }
+    else if (testGone[keypad - testKeyPad]) {
+        testLate++;
+    }
+    return KeyPad_NotHandled;
+}
+/**
+ * @brief keypad remove itself in its first callback, other keys of same frame must not fire
+ */
+static KeyPad_HandleStatus test_onRemoveSelf(KeyPad* keypad, KeyPad_KeyValue value, KeyPad_State state) {
+    uint32_t index = (uint32_t) (keypad - testKeyPad);
+    (void) value;
+    (void) state;
+    if (testGone[index]) {
+        testLate++;
+    }
+    else {
+        testGone[index] = KeyPad_remove(keypad);
+    }
+    return KeyPad_NotHandled;
+}
+
+static void test_setCallback(KeyPad* keypad, KeyPad_Callback cb) {
+#if KEYPAD_SHARED_CALLBACKS
+    (void) keypad;
+    (void) cb;
+#elif KEYPAD_MULTI_CALLBACK
+    KeyPad_onPressed(keypad, cb);
+    KeyPad_onReleased(keypad, cb);
+#else
+    KeyPad_onChange(keypad, cb);
+#endif
+}
+
+static void test_handle(uint32_t ticks) {
+    while (ticks-- > 0) {
+        KeyPad_handle();
+    }
+}
+
+static void test_removeAll(void) {
+    uint8_t index;
+    uint8_t pass;
+    // remove fail while ring is full of keypads that wait for a handle, so remove again after handle
+    for (pass = 0; pass < 2; pass++) {
+        for (index = 0; index < TEST_KEYPADS; index++) {
+            KeyPad_remove(&testKeyPad[index]);
+        }
+        KeyPad_handle();
+    }
+    for (index = 0; index < TEST_KEYPADS; index++) {
+        testGone[index] = 0;
+    }
+    // with KEYPAD_USE_DEINIT handle must not touch pins of keypad after its release
+    TEST_ASSERT(KeyPadSim_getCounters()->DeinitAccess == 0);
+}
+/**
+ * @brief removes in a callback more than KEYPAD_RETIRE_SIZE must not wait for running handle
+ */
+static void test_removeInCallback(void) {
+    uint8_t index;
+    KeyPadSim_reset(KeyPad_ActiveState_Low);
+    for (index = 0; index < TEST_KEYPADS; index++) {
+        TEST_ASSERT(KeyPad_add(&testKeyPad[index], &testConfigA));
+        test_setCallback(&testKeyPad[index], test_onRemove);
+    }
+    testRemoved = 0;
+    testLate = 0;
+    KeyPadSim_press(0, TEST_IN_LINE);
+    test_handle(4);
+    KeyPadSim_release(0, TEST_IN_LINE);
+    test_handle(4);
+    TEST_ASSERT(testRemoved == KEYPAD_RETIRE_SIZE);
+    TEST_ASSERT(testLate == 0);
+    // retired keypads released at end of handle and can add again
+    for (index = 0; index < KEYPAD_RETIRE_SIZE; index++) {
+        TEST_ASSERT(KeyPad_add(&testKeyPad[index], &testConfigA));
+    }
+    test_removeAll();
+}
+/**
+ * @brief removed keypad stay in list until end of handle, but it must not fire again
+ */
+static void test_removeSelf(void) {
+    KeyPadSim_reset(KeyPad_ActiveState_Low);
+    testLate = 0;
+    TEST_ASSERT(KeyPad_add(&testKeyPad[0], &testConfigA));
+    test_setCallback(&testKeyPad[0], test_onRemoveSelf);
+    // two keys of an output, nkro fire both of them in one frame
+    KeyPadSim_press(0, TEST_IN_LINE);
+    KeyPadSim_press(0, TEST_IN_LINE + 1);
+    test_handle(4);
+    TEST_ASSERT(testGone[0]);
+    TEST_ASSERT(testLate == 0);
+    KeyPadSim_release(0, TEST_IN_LINE);
+    KeyPadSim_release(0, TEST_IN_LINE + 1);
+    test_removeAll();
+}
+/**
+ * @brief new config apply after key of old config released
+ */
+static void test_configWhileHeld(void) {
+    KeyPad* keypad = &testKeyPad[0];
+    KeyPadSim_reset(KeyPad_ActiveState_Low);
+    TEST_ASSERT(KeyPad_add(keypad, &testConfigA));
+    test_setCallback(keypad, test_onKey);
+    KeyPadSim_press(2, TEST_IN_LINE + 2);
+    test_handle(4);
+    TEST_ASSERT(testPressed[0] == testMapA[2 * TEST_SIZE + 2]);
+    KeyPad_setConfig(keypad, &testConfigB);
+    test_handle(4);
+    TEST_ASSERT(KeyPad_getConfig(keypad) == &testConfigA);
+    KeyPadSim_release(2, TEST_IN_LINE + 2);
+    test_handle(8);
+    TEST_ASSERT(testPressed[0] == 0);
+    TEST_ASSERT(KeyPad_getConfig(keypad) == &testConfigB);
+    test_removeAll();
+}
+/**
+ * @brief run KeyPad_handle and press keys of simulator, only this thread touch lines
+ */
+static void* test_handleThread(void* arg) {
+    uint32_t tick = 0;
+    KeyPad_Pin out = 0;
+    (void) arg;
+    while (TEST_LOAD(testRunning)) {
+        if (tick % TEST_PRESS_PERIOD == 0) {
+            out = (KeyPad_Pin) ((tick / TEST_PRESS_PERIOD) % TEST_SIZE);
+            KeyPadSim_press(out, (KeyPad_Pin) (TEST_IN_LINE + out));
+        }
+        else if (tick % TEST_PRESS_PERIOD == TEST_PRESS_TICKS) {
+            KeyPadSim_release(out, (KeyPad_Pin) (TEST_IN_LINE + out));
+        }
+        KeyPad_handle();
+        TEST_STORE(testTick, ++tick);
+    }
+    return 0;
+}
+/**
+ * @brief add, remove and set config of keypads while other thread handle them
+ */
+static void test_stress(void) {
+    pthread_t thread;
+    uint32_t step;
+    uint32_t seed = 1;
+    uint8_t index;
+    KeyPadSim_reset(KeyPad_ActiveState_Low);
+    testEvents = 0;
+    testLate = 0;
+    testTick = 0;
+    testRunning = 1;
+    for (index = 0; index < TEST_KEYPADS; index++) {
+        // callbacks stay after remove, handle thread read them while main thread add keypads
+        test_setCallback(&testKeyPad[index], test_onKey);
+    }
+    pthread_create(&thread, 0, test_handleThread, 0);
+    // run steps until handle thread fire enough events on changing keypads too, threads maybe share one cpu
+    for (step = 0; step < TEST_STRESS_STEPS || (TEST_LOAD(testEvents) < TEST_STRESS_EVENTS && step < TEST_STRESS_STEPS * 100); step++) {
+        KeyPad* keypad;
+        seed = seed * 1103515245 + 12345;
+        keypad = &testKeyPad[(seed >> 16) % TEST_KEYPADS];
+        switch ((seed >> 24) % 4) {
+            case 0:
+                if (KeyPad_remove(keypad)) {
+                    TEST_STORE(testGoneTick[keypad - testKeyPad], TEST_LOAD(testTick));
+                    TEST_STORE(testGone[keypad - testKeyPad], 1);
+                }
+                break;
+            case 1:
+                KeyPad_setConfig(keypad, &testConfigB);
+                break;
+            case 2:
+                KeyPad_setConfig(keypad, &testConfigA);
+                break;
+            default:
+                TEST_STORE(testGone[keypad - testKeyPad], 0);
+                KeyPad_add(keypad, (seed & 1) ? &testConfigA : &testConfigB);
+                break;
+        }
+    }
+    TEST_STORE(testRunning, 0);
+    pthread_join(thread, 0);
+    test_removeAll();
+    for (index = 0; index < TEST_KEYPADS; index++) {
+        TEST_ASSERT(KeyPad_add(&testKeyPad[index], &testConfigA));
+    }
+    test_removeAll();
+    TEST_ASSERT(testEvents >= TEST_STRESS_EVENTS);
+    TEST_ASSERT(testLate == 0);
+}
+/**
+ * @brief only keypad of its lines add and remove while other thread scan it
+ * with KEYPAD_USE_DEINIT handle must not read or strobe its lines after they deinit
+ */
+static void test_removeWhileScan(void) {
+    pthread_t thread;
+    uint32_t step;
+    KeyPadSim_reset(KeyPad_ActiveState_Low);
+    testLate = 0;
+    testTick = 0;
+    testRunning = 1;
+    test_setCallback(&testKeyPad[0], test_onKey);
+    pthread_create(&thread, 0, test_handleThread, 0);
+    // yield after each change, so handle thread run until it preempt somewhere in scan of keypad
+    for (step = 0; step < TEST_STRESS_STEPS / 200; step++) {
+        if (KeyPad_remove(&testKeyPad[0])) {
+            TEST_STORE(testGoneTick[0], TEST_LOAD(testTick));
+            TEST_STORE(testGone[0], 1);
+        }
+        else {
+            TEST_STORE(testGone[0], 0);
+            KeyPad_add(&testKeyPad[0], &testConfigOwn);
+        }
+        sched_yield();
+    }
+    TEST_STORE(testRunning, 0);
+    pthread_join(thread, 0);
+    test_removeAll();
+    TEST_ASSERT(testLate == 0);
+}
+
+int main(void) {
+    KeyPad_init(&KeyPadSim_driver);
+    test_removeInCallback();
+    test_removeSelf();
+    test_configWhileHeld();
+    test_stress();
+    test_removeWhileScan();
+    printf("%s\n", testFailed ? "FAILED" : "passed");
+    return testFailed ? 1 : 0;
+}
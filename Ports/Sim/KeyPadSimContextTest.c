@@ -0,0 +1,164 @@
+/**
+ * @file KeyPadSimContextTest.c
+ * @author Ali Mirghasemi (ali.mirghasemi1376@gmail.com)
+ * @brief test of two populations of keypads in one process with KEYPAD_SHARD, keypads of default context
+ * use KeyPadSim and keypads of other context use a board driver, each handle scan only keypads of its context with its driver
+ * build and run with make test in this directory
+ * @version 0.1.0
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "KeyPadSim.h"
+#include <stdio.h>
+
+#if !KEYPAD_SHARD || !KEYPAD_EVENT_QUEUE
+    #error "KeyPadSimContextTest need KEYPAD_SHARD and KEYPAD_EVENT_QUEUE"
+#endif
+
+#define TEST_SIZE                           4
+#define TEST_IN_LINE                        32
+#define TEST_TICKS                          4
+
+#define TEST_ASSERT(C)                      if (!(C)) { printf("failed %s:%d: %s\n", __FILE__, __LINE__, #C); testFailed++; }
+
+static const KeyPad_PinConfig testOuts[TEST_SIZE] = {{0, 0}, {0, 1}, {0, 2}, {0, 3}};
+static const KeyPad_PinConfig testIns[TEST_SIZE] = {{0, TEST_IN_LINE}, {0, TEST_IN_LINE + 1}, {0, TEST_IN_LINE + 2}, {0, TEST_IN_LINE + 3}};
+static const KeyPad_PinConfig testBoardOuts[TEST_SIZE] = {{0, 0}, {0, 1}, {0, 2}, {0, 3}};
+static const KeyPad_PinConfig testBoardIns[TEST_SIZE] = {{0, TEST_SIZE}, {0, TEST_SIZE + 1}, {0, TEST_SIZE + 2}, {0, TEST_SIZE + 3}};
+static const KeyPad_KeyValue testMapA[TEST_SIZE * TEST_SIZE] = {
+    'a', 'b', 'c', 'd', 'e', 'f', 'g', 'h', 'i', 'j', 'k', 'l', 'm', 'n', 'o', 'p',
+};
+static const KeyPad_KeyValue testMapB[TEST_SIZE * TEST_SIZE] = {
+    'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H', 'I', 'J', 'K', 'L', 'M', 'N', 'O', 'P',
+};
+#if KEYPAD_MODE == KEYPAD_MODE_ROW_INPUT
+static const KeyPad_Config testConfigA = {testMapA, testOuts, testIns, TEST_SIZE, TEST_SIZE};
+static const KeyPad_Config testConfigB = {testMapB, testBoardOuts, testBoardIns, TEST_SIZE, TEST_SIZE};
+#else
+static const KeyPad_Config testConfigA = {testMapA, testIns, testOuts, TEST_SIZE, TEST_SIZE};
+static const KeyPad_Config testConfigB = {testMapB, testBoardIns, testBoardOuts, TEST_SIZE, TEST_SIZE};
+#endif
+
+static KeyPad_Context testContext;
+static KeyPad_Shard testShard;
+static KeyPad testKeyPadA;
+static KeyPad testKeyPadB;
+static KeyPad_KeyValue testPressedA;
+static KeyPad_KeyValue testPressedB;
+static KeyPad_Pin testBoardActive = TEST_SIZE;              /**< output of board that driven in active state */
+static KeyPad_Pin testBoardOut;                             /**< output of pressed key of board, TEST_SIZE for none */
+static KeyPad_Pin testBoardIn;
+static uint32_t testBoardReads;
+static uint32_t testFailed;
+
+static void test_initPin(const KeyPad_PinConfig* config, KeyPad_PinMode mode) {
+    (void) config;
+    (void) mode;
+}
+static uint8_t test_readPin(const KeyPad_PinConfig* config) {
+    testBoardReads++;
+    // active low, input is low while pressed key connect it to active output
+    return !(testBoardActive == testBoardOut && config->Pin == TEST_SIZE + testBoardIn);
+}
+static void test_writePin(const KeyPad_PinConfig* config, uint8_t value) {
+    if (value == KeyPad_ActiveState_Low) {
+        testBoardActive = config->Pin;
+    }
+    else if (testBoardActive == config->Pin) {
+        testBoardActive = TEST_SIZE;
+    }
+}
+
+static const KeyPad_Driver testBoardDriver = {
+    .initPin = test_initPin,
+    .readPin = test_readPin,
+    .writePin = test_writePin,
+};
+
+static KeyPad_HandleStatus test_onKey(KeyPad* keypad, KeyPad_KeyValue value, KeyPad_State state) {
+    if (state == KeyPad_State_Pressed) {
+        if (keypad == &testKeyPadA) {
+            testPressedA = value;
+        }
+        else {
+            testPressedB = value;
+        }
+    }
+    return KeyPad_NotHandled;
+}
+
+static void test_setCallback(KeyPad* keypad) {
+#if KEYPAD_SHARED_CALLBACKS
+    (void) keypad;
+#elif KEYPAD_MULTI_CALLBACK
+    KeyPad_onPressed(keypad, test_onKey);
+#else
+    KeyPad_onChange(keypad, test_onKey);
+#endif
+}
+/**
+ * @brief handle each context for some ticks, keypads of a context must not scan with driver of other context
+ */
+static void test_handle(void) {
+    uint8_t tick;
+    for (tick = 0; tick < TEST_TICKS; tick++) {
+        uint32_t simReads;
+        testBoardReads = 0;
+        KeyPadSim_resetCounters();
+        KeyPad_handle();
+        KeyPad_dispatch();
+        TEST_ASSERT(testBoardReads == 0);
+        simReads = KeyPadSim_getCounters()->ReadPin + KeyPadSim_getCounters()->ReadPort;
+        KeyPad_handleShard(&testContext, &testShard, 1);
+        KeyPad_dispatchShard(&testShard);
+        TEST_ASSERT(KeyPadSim_getCounters()->ReadPin + KeyPadSim_getCounters()->ReadPort == simReads);
+        TEST_ASSERT(testBoardReads > 0);
+    }
+}
+
+int main(void) {
+    KeyPad_init(&KeyPadSim_driver);
+    KeyPadSim_reset(KeyPad_ActiveState_Low);
+    KeyPad_initContext(&testContext, &testBoardDriver);
+    testBoardOut = TEST_SIZE;
+
+    TEST_ASSERT(KeyPad_add(&testKeyPadA, &testConfigA));
+    TEST_ASSERT(KeyPad_addContext(&testContext, &testKeyPadB, &testConfigB));
+    // a keypad can be in one context
+    TEST_ASSERT(!KeyPad_addContext(&testContext, &testKeyPadA, &testConfigA));
+    TEST_ASSERT(!KeyPad_add(&testKeyPadB, &testConfigB));
+    TEST_ASSERT(KeyPad_getContext()->ActiveLen == 1);
+    TEST_ASSERT(testContext.ActiveLen == 1);
+    test_setCallback(&testKeyPadA);
+    test_setCallback(&testKeyPadB);
+
+    // same key on lines of both populations, each keypad see only its own lines
+    KeyPadSim_press(1, TEST_IN_LINE + 1);
+    test_handle();
+    TEST_ASSERT(testPressedA == testMapA[1 * TEST_SIZE + 1]);
+    TEST_ASSERT(testPressedB == 0);
+    testBoardOut = 2;
+    testBoardIn = 2;
+    test_handle();
+    TEST_ASSERT(testPressedB == testMapB[2 * TEST_SIZE + 2]);
+
+    // remove keypad of default context, other context still handle its keypad
+    TEST_ASSERT(KeyPad_remove(&testKeyPadA));
+    TEST_ASSERT(KeyPad_getContext()->ActiveLen == 0);
+    TEST_ASSERT(testContext.ActiveLen == 1);
+    testBoardOut = TEST_SIZE;
+    test_handle();
+    testPressedB = 0;
+    testBoardOut = 3;
+    testBoardIn = 3;
+    test_handle();
+    TEST_ASSERT(testPressedB == testMapB[3 * TEST_SIZE + 3]);
+    TEST_ASSERT(KeyPad_remove(&testKeyPadB));
+    TEST_ASSERT(testContext.ActiveLen == 0);
+
+    printf("%s\n", testFailed ? "FAILED" : "passed");
+    return testFailed ? 1 : 0;
+}
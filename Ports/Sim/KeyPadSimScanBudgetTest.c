@@ -0,0 +1,119 @@
+/**
+ * @file KeyPadSimScanBudgetTest.c
+ * @author Ali Mirghasemi (ali.mirghasemi1376@gmail.com)
+ * @brief test of scan cursor of KEYPAD_SCAN_BUDGET when keypads removed, a keypad that remove itself in its callback
+ * must not make KeyPad_handle skip next keypad, in linked list and fixed array mode
+ * build and run with make test in this directory
+ * @version 0.1.0
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "KeyPadSim.h"
+#include <stdio.h>
+
+#define TEST_SIZE                           3
+#define TEST_IN_LINE                        32
+
+#if KEYPAD_SCAN_BUDGET < TEST_SIZE
+    #error "KeyPadSimScanBudgetTest need KEYPAD_SCAN_BUDGET of TEST_SIZE or more"
+#endif
+
+#define TEST_ASSERT(C)                      if (!(C)) { printf("failed %s:%d: %s\n", __FILE__, __LINE__, #C); testFailed++; }
+
+static const KeyPad_PinConfig testOuts[TEST_SIZE] = {{0, 0}, {0, 1}, {0, 2}};
+static const KeyPad_PinConfig testIns[TEST_SIZE] = {{0, TEST_IN_LINE}, {0, TEST_IN_LINE + 1}, {0, TEST_IN_LINE + 2}};
+static const KeyPad_KeyValue testMaps[TEST_SIZE] = {'a', 'b', 'c'};
+// each keypad is a single key on its own lines, so a keypad scan is one step of budget
+#if KEYPAD_MODE == KEYPAD_MODE_ROW_INPUT
+static const KeyPad_Config testConfigs[TEST_SIZE] = {
+    {&testMaps[0], &testOuts[0], &testIns[0], 1, 1},
+    {&testMaps[1], &testOuts[1], &testIns[1], 1, 1},
+    {&testMaps[2], &testOuts[2], &testIns[2], 1, 1},
+};
+#else
+static const KeyPad_Config testConfigs[TEST_SIZE] = {
+    {&testMaps[0], &testIns[0], &testOuts[0], 1, 1},
+    {&testMaps[1], &testIns[1], &testOuts[1], 1, 1},
+    {&testMaps[2], &testIns[2], &testOuts[2], 1, 1},
+};
+#endif
+
+static KeyPad testKeyPads[TEST_SIZE];
+static uint8_t testPressed[TEST_SIZE];
+static KeyPad* testSelfRemove;                              /**< keypad that remove itself on pressed */
+static uint32_t testFailed;
+
+static KeyPad_HandleStatus test_onKey(KeyPad* keypad, KeyPad_KeyValue value, KeyPad_State state) {
+    (void) value;
+    if (state == KeyPad_State_Pressed) {
+        testPressed[keypad - testKeyPads]++;
+        if (keypad == testSelfRemove) {
+            TEST_ASSERT(KeyPad_remove(keypad));
+        }
+    }
+    return KeyPad_NotHandled;
+}
+
+static void test_setCallback(KeyPad* keypad) {
+#if KEYPAD_SHARED_CALLBACKS
+    (void) keypad;
+#elif KEYPAD_MULTI_CALLBACK
+    KeyPad_onPressed(keypad, test_onKey);
+#else
+    KeyPad_onChange(keypad, test_onKey);
+#endif
+}
+/**
+ * @brief add all keypads with released keys and clear pressed counts
+ */
+static void test_begin(void) {
+    uint8_t index;
+    KeyPadSim_reset(KeyPad_ActiveState_Low);
+    for (index = 0; index < TEST_SIZE; index++) {
+        TEST_ASSERT(KeyPad_add(&testKeyPads[index], &testConfigs[index]));
+        test_setCallback(&testKeyPads[index]);
+        testPressed[index] = 0;
+    }
+    testSelfRemove = KEYPAD_NULL;
+    // complete a round, so next handle start from first keypad
+    KeyPad_handle();
+}
+
+static void test_end(void) {
+    uint8_t index;
+    for (index = 0; index < TEST_SIZE; index++) {
+        KeyPad_remove(&testKeyPads[index]);
+    }
+}
+/**
+ * @brief each keypad remove itself in its callback, all other keypads must scan in same round
+ */
+static void test_selfRemove(void) {
+    uint8_t remove;
+    uint8_t index;
+    for (remove = 0; remove < TEST_SIZE; remove++) {
+        test_begin();
+        testSelfRemove = &testKeyPads[remove];
+        for (index = 0; index < TEST_SIZE; index++) {
+            KeyPadSim_press(index, TEST_IN_LINE + index);
+        }
+        // budget cover all keypads, so one handle is a full round and skipped keypad stay unpressed
+        KeyPad_handle();
+        for (index = 0; index < TEST_SIZE; index++) {
+            TEST_ASSERT(testPressed[index] == 1);
+        }
+        test_end();
+    }
+}
+
+int main(void) {
+    KeyPad_init(&KeyPadSim_driver);
+
+    test_selfRemove();
+
+    printf("%s\n", testFailed ? "FAILED" : "passed");
+    return testFailed ? 1 : 0;
+}
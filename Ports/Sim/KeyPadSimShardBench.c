@@ -0,0 +1,215 @@
+/**
+ * @file KeyPadSimShardBench.c
+ * @author Ali Mirghasemi (ali.mirghasemi1376@gmail.com)
+ * @brief scaling benchmark of KEYPAD_SHARD, hundreds of virtual keypads handled by 1 to N threads
+ * each virtual board keep its lines in its own cache line, so threads share nothing while handle
+ * keypads and boards reset before each thread count, so all runs must dispatch same events
+ * build and run with make bench in this directory
+ * @version 0.1.0
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#include "KeyPad.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+
+#if !KEYPAD_SHARD || !KEYPAD_EVENT_QUEUE || !KEYPAD_CONFIG_IO
+    #error "KeyPadSimShardBench need KEYPAD_SHARD, KEYPAD_EVENT_QUEUE and KEYPAD_CONFIG_IO"
+#endif
+
+#define BENCH_KEYPADS                       KEYPAD_MAX_NUM
+#define BENCH_TICKS                         2000
+#define BENCH_PRESS_PERIOD                  16
+#define BENCH_SIZE                          4
+#define BENCH_MAX_THREADS                   64
+#define BENCH_MIN_THREADS                   4
+
+/**
+ * @brief lines of a virtual keypad, IO of its pins point to it
+ */
+typedef struct {
+    uint8_t                     ActiveOut;                  /**< output that driven in active state, BENCH_SIZE for none */
+    uint8_t                     PressOut;                   /**< output of pressed key */
+    uint8_t                     PressIn;                    /**< input of pressed key */
+    uint8_t                     Pressed;
+    uint32_t                    Events;                     /**< dispatched callbacks of keypad */
+    uint8_t                     Padding[56];                /**< keep boards in separate cache lines */
+} BenchBoard;
+
+typedef struct {
+    pthread_t                   Thread;
+    KeyPad_NumType              Index;
+    KeyPad_NumType              Num;
+} BenchWorker;
+
+static KeyPad_Context benchContext;
+static KeyPad benchKeyPads[BENCH_KEYPADS];
+static BenchBoard benchBoards[BENCH_KEYPADS];
+static KeyPad_PinConfig benchOuts[BENCH_KEYPADS][BENCH_SIZE];
+static KeyPad_PinConfig benchIns[BENCH_KEYPADS][BENCH_SIZE];
+static KeyPad_Config benchConfigs[BENCH_KEYPADS];
+static const KeyPad_KeyValue benchMap[BENCH_SIZE * BENCH_SIZE] = {0};
+static KeyPad_Shard benchShards[BENCH_MAX_THREADS];
+static BenchWorker benchWorkers[BENCH_MAX_THREADS];
+
+static void bench_initPin(const KeyPad_PinConfig* config, KeyPad_PinMode mode) {
+    (void) config;
+    (void) mode;
+}
+static uint8_t bench_readPin(const KeyPad_PinConfig* config) {
+    const BenchBoard* board = (const BenchBoard*) config->IO;
+    // active low, input is low while pressed key connect it to active output
+    return !(board->Pressed && board->ActiveOut == board->PressOut && config->Pin == BENCH_SIZE + board->PressIn);
+}
+static void bench_writePin(const KeyPad_PinConfig* config, uint8_t value) {
+    BenchBoard* board = (BenchBoard*) config->IO;
+    if (value == KeyPad_ActiveState_Low) {
+        board->ActiveOut = (uint8_t) config->Pin;
+    }
+    else if (board->ActiveOut == config->Pin) {
+        board->ActiveOut = BENCH_SIZE;
+    }
+}
+
+static const KeyPad_Driver benchDriver = {
+    .initPin = bench_initPin,
+    .readPin = bench_readPin,
+    .writePin = bench_writePin,
+};
+
+static KeyPad_HandleStatus bench_onKey(KeyPad* keypad, KeyPad_KeyValue value, KeyPad_State state) {
+    (void) value;
+    (void) state;
+    ((BenchBoard*) KeyPad_getConfig(keypad)->Rows[0].IO)->Events++;
+    return KeyPad_NotHandled;
+}
+/**
+ * @brief handle a shard, press and release keys of boards of its block between handles
+ */
+static void* bench_worker(void* arg) {
+    BenchWorker* worker = (BenchWorker*) arg;
+    KeyPad_Shard* shard = &benchShards[worker->Index];
+    KeyPad_NumType begin = (KeyPad_NumType) ((uint32_t) BENCH_KEYPADS * worker->Index / worker->Num);
+    KeyPad_NumType end = (KeyPad_NumType) ((uint32_t) BENCH_KEYPADS * (worker->Index + 1) / worker->Num);
+    KeyPad_NumType index;
+    uint32_t tick;
+    for (tick = 0; tick < BENCH_TICKS; tick++) {
+        if (tick % BENCH_PRESS_PERIOD == 0) {
+            for (index = begin; index < end; index++) {
+                BenchBoard* board = &benchBoards[index];
+                board->Pressed = !board->Pressed;
+                board->PressOut = (uint8_t) ((tick / BENCH_PRESS_PERIOD + index) % BENCH_SIZE);
+                board->PressIn = board->PressOut;
+            }
+        }
+        KeyPad_handleShard(&benchContext, shard, worker->Num);
+        KeyPad_dispatchShard(shard);
+    }
+    return 0;
+}
+
+static uint32_t bench_events(void) {
+    uint32_t events = 0;
+    KeyPad_NumType index;
+    for (index = 0; index < BENCH_KEYPADS; index++) {
+        events += benchBoards[index].Events;
+    }
+    return events;
+}
+/**
+ * @brief release lines of boards and add keypads again, so state of previous run not change events of next run
+ * all keypads remove before add, so keypad of index stay in block of worker that press its keys
+ */
+static uint8_t bench_reset(void) {
+    KeyPad_NumType index;
+    for (index = 0; index < BENCH_KEYPADS; index++) {
+        KeyPad_remove(&benchKeyPads[index]);
+        benchBoards[index] = (BenchBoard) {0};
+        benchBoards[index].ActiveOut = BENCH_SIZE;
+    }
+    for (index = 0; index < BENCH_KEYPADS; index++) {
+        KeyPad* keypad = &benchKeyPads[index];
+        if (!KeyPad_addContext(&benchContext, keypad, &benchConfigs[index])) {
+            printf("can't add keypad %u\n", index);
+            return 0;
+        }
+    #if KEYPAD_SHARED_CALLBACKS
+    #elif KEYPAD_MULTI_CALLBACK
+        KeyPad_onPressed(keypad, bench_onKey);
+        KeyPad_onReleased(keypad, bench_onKey);
+    #else
+        KeyPad_onChange(keypad, bench_onKey);
+    #endif
+    }
+    return 1;
+}
+
+int main(void) {
+    KeyPad_NumType index;
+    KeyPad_NumType threads;
+    KeyPad_NumType maxThreads;
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    double base = 0;
+    uint32_t events = 0;
+
+    // keypads of bench are apart from default context of KeyPad_add and KeyPad_handle
+    KeyPad_initContext(&benchContext, &benchDriver);
+    for (index = 0; index < BENCH_KEYPADS; index++) {
+        uint8_t line;
+        for (line = 0; line < BENCH_SIZE; line++) {
+            benchOuts[index][line].IO = &benchBoards[index];
+            benchOuts[index][line].Pin = line;
+            benchIns[index][line].IO = &benchBoards[index];
+            benchIns[index][line].Pin = (KeyPad_Pin) (BENCH_SIZE + line);
+        }
+        benchConfigs[index] = (KeyPad_Config) {benchMap, benchOuts[index], benchIns[index], BENCH_SIZE, BENCH_SIZE};
+    }
+    maxThreads = (KeyPad_NumType) (cores > BENCH_MIN_THREADS ? cores : BENCH_MIN_THREADS);
+    if (maxThreads > BENCH_MAX_THREADS) {
+        maxThreads = BENCH_MAX_THREADS;
+    }
+    printf("%u keypads, %ld cores\n", BENCH_KEYPADS, cores);
+    printf("%-8s %-12s %-12s %-8s %-8s\n", "threads", "ms", "ns/keypad", "speedup", "events");
+    for (threads = 1; threads <= maxThreads; threads *= 2) {
+        struct timespec start;
+        struct timespec end;
+        double ns;
+        if (!bench_reset()) {
+            return 1;
+        }
+        for (index = 0; index < threads; index++) {
+            benchShards[index] = (KeyPad_Shard) {0};
+            benchShards[index].Index = index;
+            benchWorkers[index].Index = index;
+            benchWorkers[index].Num = threads;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (index = 0; index < threads; index++) {
+            pthread_create(&benchWorkers[index].Thread, 0, bench_worker, &benchWorkers[index]);
+        }
+        for (index = 0; index < threads; index++) {
+            pthread_join(benchWorkers[index].Thread, 0);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        ns = (double) (end.tv_sec - start.tv_sec) * 1e9 + (double) (end.tv_nsec - start.tv_nsec);
+        if (base == 0) {
+            base = ns;
+        }
+        printf("%-8u %-12.2f %-12.1f %-8.2f %-8u\n", threads, ns / 1e6, ns / ((double) BENCH_TICKS * BENCH_KEYPADS),
+               base / ns, bench_events());
+        if (threads == 1) {
+            events = bench_events();
+        }
+        else if (events != bench_events()) {
+            printf("events of %u threads differ from 1 thread\n", threads);
+            return 1;
+        }
+    }
+    return 0;
+}
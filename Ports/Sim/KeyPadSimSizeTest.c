@@ -0,0 +1,67 @@
+/**
+ * @file KeyPadSimSizeTest.c
+ * @author Ali Mirghasemi (ali.mirghasemi1376@gmail.com)
+ * @brief report size of KeyPad struct, check it is not bigger than links, config, callbacks and small fields
+ * and check small fields of keypad share a single word
+ * with KEYPAD_SHARED_CALLBACKS and fixed keypads, keypad must be config pointer, table pointer and that word
+ * build and run with make test in this directory
+ * @version 0.1.0
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "KeyPad.h"
+#include <stddef.h>
+#include <stdio.h>
+
+#define TEST_ASSERT(C)                      if (!(C)) { printf("failed %s:%d: %s\n", __FILE__, __LINE__, #C); testFailed++; }
+#define TEST_ALIGN(SIZE, ALIGN)             (((SIZE) + (ALIGN) - 1) / (ALIGN) * (ALIGN))
+
+#if KEYPAD_MAX_NUM != -1
+    #define TEST_SMALL_FIELDS               offsetof(KeyPad, Index)
+#else
+    #define TEST_SMALL_FIELDS               offsetof(KeyPad, RowIndex)
+#endif
+/**
+ * @brief size of keypad if only pointers and word of small fields exist
+ */
+#define TEST_MIN_SIZE                       TEST_ALIGN(TEST_SMALL_FIELDS + sizeof(uint32_t), sizeof(void*))
+/**
+ * @brief links of keypad in list, linked list mode keep Previous and add Next for constant time remove,
+ * fixed keypads only add index of active list
+ */
+#if KEYPAD_MAX_NUM == -1
+    #define TEST_LINKS                      (2 * sizeof(void*))
+#else
+    #define TEST_LINKS                      sizeof(KeyPad_NumType)
+#endif
+#if KEYPAD_ARGS
+    #define TEST_ARGS                       sizeof(void*)
+#else
+    #define TEST_ARGS                       0
+#endif
+/**
+ * @brief upper bound of keypad, links, args, config, callbacks, row and column indices and a byte of flags
+ */
+#define TEST_MAX_SIZE                       TEST_ALIGN(TEST_LINKS + TEST_ARGS + sizeof(const KeyPad_Config*) + sizeof(KeyPad_Callbacks) + \
+                                                       2 * sizeof(KeyPad_LenType) + 1, sizeof(void*))
+
+static uint32_t testFailed;
+
+int main(void) {
+    printf("sizeof(KeyPad) %u, pointers %u, small fields %u, upper bound %u\n",
+           (unsigned) sizeof(KeyPad), (unsigned) TEST_SMALL_FIELDS, (unsigned) (sizeof(KeyPad) - TEST_SMALL_FIELDS), (unsigned) TEST_MAX_SIZE);
+    TEST_ASSERT(sizeof(KeyPad) <= TEST_MAX_SIZE);
+    // index, row and column indices and flags fit in a single word after pointers
+    TEST_ASSERT(sizeof(KeyPad) == TEST_MIN_SIZE);
+#if KEYPAD_SHARED_CALLBACKS
+    TEST_ASSERT(sizeof(((KeyPad*) 0)->Callbacks) == sizeof(void*));
+#endif
+#if KEYPAD_SHARED_CALLBACKS && KEYPAD_MAX_NUM != -1 && !KEYPAD_ARGS
+    TEST_ASSERT(TEST_SMALL_FIELDS == 2 * sizeof(void*));
+#endif
+    printf("%s\n", testFailed ? "FAILED" : "passed");
+    return testFailed ? 1 : 0;
+}
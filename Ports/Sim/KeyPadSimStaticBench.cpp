@@ -0,0 +1,137 @@
+/**
+ * @file KeyPadSimStaticBench.cpp
+ * @author Ali Mirghasemi (ali.mirghasemi1376@gmail.com)
+ * @brief benchmark of KeyPadStatic::Matrix against KeyPad_handle on simulated lines, print ns per handle for matrix sizes
+ * both paths drive same lines of KeyPadSim with same script, C path through KeyPad_Driver and C++ path through static driver
+ * build and run with make bench in this directory
+ * @version 0.1.0
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "KeyPadSim.h"
+#include "KeyPad.hpp"
+#include <chrono>
+#include <stdio.h>
+
+#define BENCH_TICKS                         100000
+#define BENCH_PRESS_PERIOD                  1000
+#define BENCH_PRESS_TICKS                   200
+#define BENCH_MAX_SIZE                      16
+#define BENCH_IN_LINE                       32
+
+/**
+ * @brief static driver on lines of KeyPadSim, output N is line N and input N is line BENCH_IN_LINE + N
+ */
+struct BenchDriver {
+    static inline void initOut(KeyPad_LenType) {}
+    static inline void initIn(KeyPad_LenType, KeyPad_PinMode) {}
+    static inline void writeOut(KeyPad_LenType index, uint8_t value) {
+        KeyPadSim_setLine((KeyPad_Pin) index, value);
+    }
+    static inline uint8_t readIn(KeyPad_LenType index) {
+        return KeyPadSim_getLine((KeyPad_Pin) (BENCH_IN_LINE + index));
+    }
+};
+
+extern const KeyPad_KeyValue benchMap[BENCH_MAX_SIZE * BENCH_MAX_SIZE];
+const KeyPad_KeyValue benchMap[BENCH_MAX_SIZE * BENCH_MAX_SIZE] = {0};
+
+static KeyPad_PinConfig benchOuts[BENCH_MAX_SIZE];
+static KeyPad_PinConfig benchIns[BENCH_MAX_SIZE];
+static KeyPadSim_Step benchScript[BENCH_TICKS / BENCH_PRESS_PERIOD * 2];
+static KeyPad benchKeyPad;
+
+/**
+ * @brief a key press each BENCH_PRESS_PERIOD ticks, walk on diagonal of matrix, same as KeyPadSimBench
+ */
+static uint32_t bench_makeScript(uint8_t size) {
+    uint32_t len = 0;
+    uint32_t tick;
+    for (tick = BENCH_PRESS_PERIOD; tick + BENCH_PRESS_TICKS < BENCH_TICKS; tick += BENCH_PRESS_PERIOD) {
+        KeyPad_Pin line = (KeyPad_Pin) ((tick / BENCH_PRESS_PERIOD) % size);
+        benchScript[len++] = {tick, line, (KeyPad_Pin) (BENCH_IN_LINE + line), 1};
+        benchScript[len++] = {tick + BENCH_PRESS_TICKS, line, (KeyPad_Pin) (BENCH_IN_LINE + line), 0};
+    }
+    return len;
+}
+
+static KeyPad_HandleStatus bench_onKey(KeyPad* keypad, KeyPad_KeyValue value, KeyPad_State state) {
+    (void) keypad;
+    (void) value;
+    (void) state;
+    return KeyPad_NotHandled;
+}
+
+template <typename Keypad>
+static KeyPad_HandleStatus bench_onMatrixKey(Keypad& keypad, KeyPad_KeyValue value, KeyPad_State state) {
+    (void) keypad;
+    (void) value;
+    (void) state;
+    return KeyPad_NotHandled;
+}
+/**
+ * @brief run C path on one keypad, return ns per handle
+ */
+static double bench_c(uint8_t size) {
+    KeyPadSim_Bench result;
+#if KEYPAD_MODE == KEYPAD_MODE_ROW_INPUT
+    KeyPad_Config config = {benchMap, benchOuts, benchIns, (KeyPad_LenType) size, (KeyPad_LenType) size};
+#else
+    KeyPad_Config config = {benchMap, benchIns, benchOuts, (KeyPad_LenType) size, (KeyPad_LenType) size};
+#endif
+    KeyPadSim_reset(KeyPad_ActiveState_Low);
+    KeyPadSim_setScript(benchScript, bench_makeScript(size));
+    KeyPad_add(&benchKeyPad, &config);
+#if KEYPAD_SHARED_CALLBACKS
+#elif KEYPAD_MULTI_CALLBACK
+    KeyPad_onPressed(&benchKeyPad, bench_onKey);
+    KeyPad_onReleased(&benchKeyPad, bench_onKey);
+#else
+    KeyPad_onChange(&benchKeyPad, bench_onKey);
+#endif
+    KeyPadSim_bench(BENCH_TICKS, &result);
+    KeyPad_remove(&benchKeyPad);
+    return result.NsPerHandle;
+}
+/**
+ * @brief run C++ path on same script, return ns per handle
+ */
+template <KeyPad_LenType SIZE>
+static double bench_static(void) {
+    typedef KeyPadStatic::Matrix<SIZE, SIZE, benchMap, BenchDriver> Matrix;
+    static Matrix keypad;
+    uint32_t count = BENCH_TICKS;
+    KeyPadSim_reset(KeyPad_ActiveState_Low);
+    KeyPadSim_setScript(benchScript, bench_makeScript(SIZE));
+    keypad.init();
+    keypad.onPressed(bench_onMatrixKey<Matrix>);
+    keypad.onReleased(bench_onMatrixKey<Matrix>);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    while (count-- > 0) {
+        KeyPadSim_step();
+        keypad.handle();
+    }
+    std::chrono::steady_clock::duration elapsed = std::chrono::steady_clock::now() - start;
+    return (double) std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() / BENCH_TICKS;
+}
+
+static void bench_print(uint8_t size, double c, double cpp) {
+    printf("%2ux%-5u %-12.1f %-12.1f %-8.2f\n", size, size, c, cpp, cpp > 0 ? c / cpp : 0);
+}
+
+int main(void) {
+    uint8_t index;
+    for (index = 0; index < BENCH_MAX_SIZE; index++) {
+        benchOuts[index].Pin = index;
+        benchIns[index].Pin = (KeyPad_Pin) (BENCH_IN_LINE + index);
+    }
+    KeyPad_init(&KeyPadSim_driver);
+    printf("%-8s %-12s %-12s %-8s\n", "matrix", "c ns", "c++ ns", "speedup");
+    bench_print(4, bench_c(4), bench_static<4>());
+    bench_print(8, bench_c(8), bench_static<8>());
+    bench_print(16, bench_c(16), bench_static<16>());
+    return 0;
+}
@@ -0,0 +1,162 @@
+/**
+ * @file KeyPadSimTraceTest.c
+ * @author Ali Mirghasemi (ali.mirghasemi1376@gmail.com)
+ * @brief test of KeyPadTrace, record a scripted KeyPadSim session with recorder driver, replay stream of it
+ * with replay driver and check both runs fire same callbacks on same ticks
+ * build and run with make test in this directory
+ * @version 0.1.0
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "KeyPadSim.h"
+#include "KeyPadTrace.h"
+#include <stdio.h>
+
+#define TEST_SIZE                           4
+#define TEST_IN_LINE                        32
+#define TEST_TICKS                          200
+#define TEST_STREAM_SIZE                    4096
+#define TEST_MAX_EVENTS                     512
+
+#define TEST_ASSERT(C)                      if (!(C)) { printf("failed %s:%d: %s\n", __FILE__, __LINE__, #C); testFailed++; }
+
+/**
+ * @brief a callback that keypad fired
+ */
+typedef struct {
+    uint32_t                    Tick;
+    KeyPad_KeyValue             Value;
+    KeyPad_State                State;
+} Test_Event;
+
+/**
+ * @brief events of a run
+ */
+typedef struct {
+    Test_Event                  Events[TEST_MAX_EVENTS];
+    uint16_t                    Len;
+} Test_Log;
+
+static const KeyPad_PinConfig testOuts[TEST_SIZE] = {{0, 0}, {0, 1}, {0, 2}, {0, 3}};
+static const KeyPad_PinConfig testIns[TEST_SIZE] = {{0, TEST_IN_LINE}, {0, TEST_IN_LINE + 1}, {0, TEST_IN_LINE + 2}, {0, TEST_IN_LINE + 3}};
+static const KeyPad_KeyValue testMap[TEST_SIZE * TEST_SIZE] = {
+    '1', '2', '3', 'A',
+    '4', '5', '6', 'B',
+    '7', '8', '9', 'C',
+    '*', '0', '#', 'D',
+};
+#if KEYPAD_MODE == KEYPAD_MODE_ROW_INPUT
+static const KeyPad_Config testConfig = {testMap, testOuts, testIns, TEST_SIZE, TEST_SIZE};
+#else
+static const KeyPad_Config testConfig = {testMap, testIns, testOuts, TEST_SIZE, TEST_SIZE};
+#endif
+static const KeyPadTrace_KeyPad testTraced[] = {
+    {&testConfig, KeyPad_ActiveState_Low},
+};
+// short press, long hold and press of second key while first is held
+static const KeyPadSim_Step testScript[] = {
+    {5, 1, TEST_IN_LINE + 2, 1},
+    {9, 1, TEST_IN_LINE + 2, 0},
+    {20, 3, TEST_IN_LINE + 0, 1},
+    {90, 3, TEST_IN_LINE + 0, 0},
+    {110, 0, TEST_IN_LINE + 3, 1},
+    {114, 2, TEST_IN_LINE + 1, 1},
+    {130, 0, TEST_IN_LINE + 3, 0},
+    {136, 2, TEST_IN_LINE + 1, 0},
+};
+
+static KeyPad testKeyPad;
+static uint8_t testStream[TEST_STREAM_SIZE];
+static uint32_t testStreamLen;
+static Test_Log testRecord;
+static Test_Log testReplay;
+static Test_Log* testLog;                                   /**< log of current run */
+static uint32_t testFailed;
+
+static void test_sink(const uint8_t* data, uint16_t len) {
+    TEST_ASSERT(testStreamLen + len <= TEST_STREAM_SIZE);
+    if (testStreamLen + len <= TEST_STREAM_SIZE) {
+        while (len-- > 0) {
+            testStream[testStreamLen++] = *data++;
+        }
+    }
+}
+
+static KeyPad_HandleStatus test_onKey(KeyPad* keypad, KeyPad_KeyValue value, KeyPad_State state) {
+    (void) keypad;
+    if (state != KeyPad_State_None && testLog->Len < TEST_MAX_EVENTS) {
+        Test_Event* event = &testLog->Events[testLog->Len++];
+        event->Tick = KeyPadTrace_getTick();
+        event->Value = value;
+        event->State = state;
+    }
+    return KeyPad_NotHandled;
+}
+
+static void test_add(void) {
+    TEST_ASSERT(KeyPad_add(&testKeyPad, &testConfig));
+#if KEYPAD_MULTI_CALLBACK
+    KeyPad_onPressed(&testKeyPad, test_onKey);
+    KeyPad_onReleased(&testKeyPad, test_onKey);
+#else
+    KeyPad_onChange(&testKeyPad, test_onKey);
+#endif
+}
+/**
+ * @brief run script on KeyPadSim with recorder driver and write stream
+ */
+static void test_record(void) {
+    uint32_t tick;
+    testLog = &testRecord;
+    KeyPadSim_reset(KeyPad_ActiveState_Low);
+    KeyPadSim_setScript(testScript, sizeof(testScript) / sizeof(testScript[0]));
+    KeyPad_init(KeyPadTrace_record(&KeyPadSim_driver, testTraced, 1, test_sink));
+    test_add();
+    for (tick = 0; tick < TEST_TICKS; tick++) {
+        KeyPadSim_step();
+        KeyPad_handle();
+        KeyPadTrace_endTick();
+    }
+    TEST_ASSERT(KeyPad_remove(&testKeyPad));
+}
+/**
+ * @brief run stream with replay driver for same ticks as record
+ */
+static void test_replay(void) {
+    testLog = &testReplay;
+    KeyPadTrace_replay(testTraced, 1, testStream, testStreamLen);
+    KeyPad_init(&KeyPadTrace_replayDriver);
+    test_add();
+    while (KeyPadTrace_getTick() < TEST_TICKS) {
+        KeyPadTrace_step();
+    }
+    TEST_ASSERT(KeyPad_remove(&testKeyPad));
+}
+
+int main(void) {
+    uint16_t index;
+
+    test_record();
+    test_replay();
+
+    printf("stream %u bytes for %u ticks, %u events\n", (unsigned) testStreamLen, (unsigned) TEST_TICKS, (unsigned) testRecord.Len);
+    // every press and release of script fire a callback
+    TEST_ASSERT(testRecord.Len >= sizeof(testScript) / sizeof(testScript[0]));
+    TEST_ASSERT(testReplay.Len == testRecord.Len);
+    for (index = 0; index < testRecord.Len && index < testReplay.Len; index++) {
+        const Test_Event* record = &testRecord.Events[index];
+        const Test_Event* replay = &testReplay.Events[index];
+        if (record->Tick != replay->Tick || record->Value != replay->Value || record->State != replay->State) {
+            printf("event %u: record %u '%c' %u, replay %u '%c' %u\n", (unsigned) index,
+                   (unsigned) record->Tick, record->Value, (unsigned) record->State,
+                   (unsigned) replay->Tick, replay->Value, (unsigned) replay->State);
+            testFailed++;
+        }
+    }
+
+    printf("%s\n", testFailed ? "FAILED" : "passed");
+    return testFailed ? 1 : 0;
+}
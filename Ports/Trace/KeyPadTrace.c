@@ -0,0 +1,339 @@
+#include "KeyPadTrace.h"
+
+#if KEYPAD_MODE == KEYPAD_MODE_ROW_INPUT
+    #define __outPins(C)                (C)->Columns
+    #define __outNum(C)                 (C)->ColumnsLen
+    #define __inPins(C)                 (C)->Rows
+    #define __inNum(C)                  (C)->RowsLen
+#else
+    #define __outPins(C)                (C)->Rows
+    #define __outNum(C)                 (C)->RowsLen
+    #define __inPins(C)                 (C)->Columns
+    #define __inNum(C)                  (C)->ColumnsLen
+#endif
+
+#define __INDEX_NONE                    ((KeyPad_LenType) -1)
+#define __isSingle(MASK)                ((MASK) != 0 && ((MASK) & ((MASK) - 1)) == 0)
+
+/* private variables */
+static KeyPad_Driver traceRecordDriver;
+static const KeyPad_Driver* traceDriver;                    /**< driver of user that recorder forward calls to it */
+static const KeyPadTrace_KeyPad* traceKeyPads;
+static uint8_t traceLen;
+static KeyPadTrace_SinkFn traceSink;
+static KeyPad_PortMask traceActive[KEYPADTRACE_MAX_KEYPADS];                         /**< outputs of each keypad that are in active level */
+static KeyPad_PortMask traceFrame[KEYPADTRACE_MAX_KEYPADS][KEYPADTRACE_MAX_OUT];     /**< frame of current tick */
+static KeyPad_PortMask tracePrevious[KEYPADTRACE_MAX_KEYPADS][KEYPADTRACE_MAX_OUT];  /**< frame of previous tick, just in record */
+static uint8_t traceRecord[KEYPADTRACE_RECORD_SIZE];
+static uint32_t traceTick;
+static uint32_t traceRecordTick;                            /**< tick of last record in record, tick of next record in replay */
+static const uint8_t* traceData;
+static uint32_t traceSize;
+
+static void KeyPadTrace_recordInitPin(const KeyPad_PinConfig* config, KeyPad_PinMode mode);
+static uint8_t KeyPadTrace_recordReadPin(const KeyPad_PinConfig* config);
+static void KeyPadTrace_recordWritePin(const KeyPad_PinConfig* config, uint8_t value);
+#if KEYPAD_USE_DEINIT
+static void KeyPadTrace_recordDeinitPin(const KeyPad_PinConfig* config);
+#endif // KEYPAD_USE_DEINIT
+#if KEYPAD_USE_PORT
+static KeyPad_PortMask KeyPadTrace_recordReadPort(const KeyPad_PinConfig* configs, KeyPad_LenType len);
+static void KeyPadTrace_recordWritePort(const KeyPad_PinConfig* configs, KeyPad_LenType len, KeyPad_PortMask value);
+#endif // KEYPAD_USE_PORT
+static void KeyPadTrace_replayInitPin(const KeyPad_PinConfig* config, KeyPad_PinMode mode);
+static uint8_t KeyPadTrace_replayReadPin(const KeyPad_PinConfig* config);
+static void KeyPadTrace_writeOut(const KeyPad_PinConfig* config, uint8_t value);
+static void KeyPadTrace_sampleIn(const KeyPad_PinConfig* config, uint8_t value);
+static KeyPad_LenType KeyPadTrace_indexOf(const KeyPad_PinConfig* pins, KeyPad_LenType len, const KeyPad_PinConfig* config);
+static KeyPad_LenType KeyPadTrace_firstOut(KeyPad_PortMask active);
+static uint16_t KeyPadTrace_putVarint(uint8_t* buf, uint32_t value);
+static uint8_t KeyPadTrace_getVarint(uint32_t* value);
+static void KeyPadTrace_clear(const KeyPadTrace_KeyPad* keypads, uint8_t len);
+
+const KeyPad_Driver KeyPadTrace_replayDriver = {
+    .initPin = KeyPadTrace_replayInitPin,
+    .readPin = KeyPadTrace_replayReadPin,
+    .writePin = KeyPadTrace_writeOut,
+};
+
+/**
+ * @brief start record of keypads, stream write through sink
+ * 
+ * @param driver driver of user
+ * @param keypads keypads that must record, order of them is index of keypad in stream
+ * @param len number of keypads
+ * @param sink receive records of stream
+ * @return const KeyPad_Driver* recorder driver, pass it to KeyPad_init
+ */
+const KeyPad_Driver* KeyPadTrace_record(const KeyPad_Driver* driver, const KeyPadTrace_KeyPad* keypads, uint8_t len, KeyPadTrace_SinkFn sink) {
+    traceDriver = driver;
+    traceSink = sink;
+    KeyPadTrace_clear(keypads, len);
+    // optional functions stay null if user driver don't have them
+    traceRecordDriver = *driver;
+    traceRecordDriver.initPin = KeyPadTrace_recordInitPin;
+    traceRecordDriver.readPin = KeyPadTrace_recordReadPin;
+    traceRecordDriver.writePin = KeyPadTrace_recordWritePin;
+#if KEYPAD_USE_DEINIT
+    if (driver->deinitPin) {
+        traceRecordDriver.deinitPin = KeyPadTrace_recordDeinitPin;
+    }
+#endif // KEYPAD_USE_DEINIT
+#if KEYPAD_USE_PORT
+    if (driver->readPort) {
+        traceRecordDriver.readPort = KeyPadTrace_recordReadPort;
+    }
+    if (driver->writePort) {
+        traceRecordDriver.writePort = KeyPadTrace_recordWritePort;
+    }
+#endif // KEYPAD_USE_PORT
+    return &traceRecordDriver;
+}
+/**
+ * @brief user must call it after each KeyPad_handle in record
+ * write a record if frame of tick is different from previous tick
+ */
+void KeyPadTrace_endTick(void) {
+    uint16_t len = KeyPadTrace_putVarint(traceRecord, traceTick - traceRecordTick);
+    uint16_t header = len;
+    uint8_t keypad;
+    uint8_t outIndex;
+    for (keypad = 0; keypad < traceLen; keypad++) {
+        for (outIndex = 0; outIndex < KEYPADTRACE_MAX_OUT; outIndex++) {
+            KeyPad_PortMask changed = traceFrame[keypad][outIndex] ^ tracePrevious[keypad][outIndex];
+            if (changed) {
+                traceRecord[len++] = keypad;
+                traceRecord[len++] = outIndex;
+                len += KeyPadTrace_putVarint(&traceRecord[len], changed);
+                tracePrevious[keypad][outIndex] = traceFrame[keypad][outIndex];
+            }
+            traceFrame[keypad][outIndex] = 0;
+        }
+    }
+    if (len != header) {
+        traceRecord[len++] = KEYPADTRACE_END;
+        traceSink(traceRecord, len);
+        traceRecordTick = traceTick;
+    }
+    traceTick++;
+}
+/**
+ * @brief start replay of stream, keypads must be same as record
+ * user must add keypads with same configs and same order of record after KeyPad_init(&KeyPadTrace_replayDriver)
+ */
+void KeyPadTrace_replay(const KeyPadTrace_KeyPad* keypads, uint8_t len, const uint8_t* data, uint32_t size) {
+    KeyPadTrace_clear(keypads, len);
+    traceData = data;
+    traceSize = size;
+    if (!KeyPadTrace_getVarint(&traceRecordTick)) {
+        traceSize = 0;
+    }
+}
+/**
+ * @brief apply record of current tick and call KeyPad_handle
+ * host can call it in a loop for replay faster than real time
+ * 
+ * @return uint8_t 1 if stream has more records
+ */
+uint8_t KeyPadTrace_step(void) {
+    uint32_t changed;
+    uint32_t delta;
+    uint8_t keypad;
+    uint8_t outIndex;
+    if (traceSize > 0 && traceRecordTick == traceTick) {
+        while (traceSize > 0 && *traceData != KEYPADTRACE_END) {
+            keypad = *traceData++;
+            traceSize--;
+            if (traceSize == 0) {
+                break;
+            }
+            outIndex = *traceData++;
+            traceSize--;
+            if (!KeyPadTrace_getVarint(&changed)) {
+                break;
+            }
+            if (keypad < traceLen && outIndex < KEYPADTRACE_MAX_OUT) {
+                traceFrame[keypad][outIndex] ^= (KeyPad_PortMask) changed;
+            }
+        }
+        if (traceSize > 0) {
+            // skip end of record
+            traceData++;
+            traceSize--;
+        }
+        if (KeyPadTrace_getVarint(&delta)) {
+            traceRecordTick += delta;
+        }
+        else {
+            traceSize = 0;
+        }
+    }
+    KeyPad_handle();
+    traceTick++;
+    return traceSize > 0;
+}
+/**
+ * @brief return number of ticks that recorded or replayed
+ */
+uint32_t KeyPadTrace_getTick(void) {
+    return traceTick;
+}
+
+static void KeyPadTrace_recordInitPin(const KeyPad_PinConfig* config, KeyPad_PinMode mode) {
+    traceDriver->initPin(config, mode);
+}
+static uint8_t KeyPadTrace_recordReadPin(const KeyPad_PinConfig* config) {
+    uint8_t value = traceDriver->readPin(config);
+    KeyPadTrace_sampleIn(config, value);
+    return value;
+}
+static void KeyPadTrace_recordWritePin(const KeyPad_PinConfig* config, uint8_t value) {
+    traceDriver->writePin(config, value);
+    KeyPadTrace_writeOut(config, value);
+}
+#if KEYPAD_USE_DEINIT
+static void KeyPadTrace_recordDeinitPin(const KeyPad_PinConfig* config) {
+    traceDriver->deinitPin(config);
+}
+#endif // KEYPAD_USE_DEINIT
+#if KEYPAD_USE_PORT
+static KeyPad_PortMask KeyPadTrace_recordReadPort(const KeyPad_PinConfig* configs, KeyPad_LenType len) {
+    KeyPad_PortMask value = traceDriver->readPort(configs, len);
+    KeyPad_LenType index;
+    for (index = 0; index < len; index++) {
+        KeyPadTrace_sampleIn(&configs[index], (value >> index) & 1);
+    }
+    return value;
+}
+static void KeyPadTrace_recordWritePort(const KeyPad_PinConfig* configs, KeyPad_LenType len, KeyPad_PortMask value) {
+    KeyPad_LenType index;
+    traceDriver->writePort(configs, len, value);
+    for (index = 0; index < len; index++) {
+        KeyPadTrace_writeOut(&configs[index], (value >> index) & 1);
+    }
+}
+#endif // KEYPAD_USE_PORT
+static void KeyPadTrace_replayInitPin(const KeyPad_PinConfig* config, KeyPad_PinMode mode) {
+    // nothing to init on host
+    (void) config;
+    (void) mode;
+}
+/**
+ * @brief input is active if an active output of its keypad has it in frame
+ */
+static uint8_t KeyPadTrace_replayReadPin(const KeyPad_PinConfig* config) {
+    uint8_t keypad;
+    uint8_t level = 1;
+    for (keypad = 0; keypad < traceLen; keypad++) {
+        const KeyPad_Config* cfg = traceKeyPads[keypad].Config;
+        KeyPad_LenType inIndex = KeyPadTrace_indexOf(__inPins(cfg), __inNum(cfg), config);
+        if (inIndex != __INDEX_NONE) {
+            KeyPad_PortMask active = traceActive[keypad];
+            KeyPad_LenType outIndex = 0;
+            level = !traceKeyPads[keypad].ActiveState;
+            while (active) {
+                if ((active & 1) && ((traceFrame[keypad][outIndex] >> inIndex) & 1)) {
+                    return traceKeyPads[keypad].ActiveState;
+                }
+                active >>= 1;
+                outIndex++;
+            }
+        }
+    }
+    return level;
+}
+/**
+ * @brief keep outputs that are in active level
+ */
+static void KeyPadTrace_writeOut(const KeyPad_PinConfig* config, uint8_t value) {
+    uint8_t keypad;
+    for (keypad = 0; keypad < traceLen; keypad++) {
+        const KeyPad_Config* cfg = traceKeyPads[keypad].Config;
+        KeyPad_LenType outIndex = KeyPadTrace_indexOf(__outPins(cfg), __outNum(cfg), config);
+        if (outIndex != __INDEX_NONE && outIndex < KEYPADTRACE_MAX_OUT) {
+            if ((value != 0) == traceKeyPads[keypad].ActiveState) {
+                traceActive[keypad] |= (KeyPad_PortMask) 1 << outIndex;
+            }
+            else {
+                traceActive[keypad] &= ~((KeyPad_PortMask) 1 << outIndex);
+            }
+        }
+    }
+}
+/**
+ * @brief add active input into frame, just when one output of keypad is active
+ * so reads of idle mode that drive all outputs don't record
+ */
+static void KeyPadTrace_sampleIn(const KeyPad_PinConfig* config, uint8_t value) {
+    uint8_t keypad;
+    for (keypad = 0; keypad < traceLen; keypad++) {
+        const KeyPad_Config* cfg = traceKeyPads[keypad].Config;
+        KeyPad_LenType inIndex = KeyPadTrace_indexOf(__inPins(cfg), __inNum(cfg), config);
+        if (inIndex != __INDEX_NONE &&
+            inIndex < (KeyPad_LenType) (sizeof(KeyPad_PortMask) * 8) &&
+            __isSingle(traceActive[keypad]) &&
+            (value != 0) == traceKeyPads[keypad].ActiveState) {
+            traceFrame[keypad][KeyPadTrace_firstOut(traceActive[keypad])] |= (KeyPad_PortMask) 1 << inIndex;
+        }
+    }
+}
+/**
+ * @brief return index of config in pins array, -1 if it's not in array
+ */
+static KeyPad_LenType KeyPadTrace_indexOf(const KeyPad_PinConfig* pins, KeyPad_LenType len, const KeyPad_PinConfig* config) {
+    if (pins != KEYPAD_CONFIG_NULL && config >= pins && config < pins + len) {
+        return (KeyPad_LenType) (config - pins);
+    }
+    return __INDEX_NONE;
+}
+static KeyPad_LenType KeyPadTrace_firstOut(KeyPad_PortMask active) {
+    KeyPad_LenType outIndex = 0;
+    while ((active & 1) == 0) {
+        active >>= 1;
+        outIndex++;
+    }
+    return outIndex;
+}
+static uint16_t KeyPadTrace_putVarint(uint8_t* buf, uint32_t value) {
+    uint16_t len = 0;
+    while (value >= 0x80) {
+        buf[len++] = (uint8_t) (value | 0x80);
+        value >>= 7;
+    }
+    buf[len++] = (uint8_t) value;
+    return len;
+}
+/**
+ * @brief read varint from stream of replay
+ * 
+ * @return uint8_t 0 if stream ended
+ */
+static uint8_t KeyPadTrace_getVarint(uint32_t* value) {
+    uint8_t shift = 0;
+    *value = 0;
+    while (traceSize > 0) {
+        uint8_t byte = *traceData++;
+        traceSize--;
+        *value |= (uint32_t) (byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return 1;
+        }
+        shift += 7;
+    }
+    return 0;
+}
+static void KeyPadTrace_clear(const KeyPadTrace_KeyPad* keypads, uint8_t len) {
+    uint8_t keypad;
+    uint8_t outIndex;
+    traceKeyPads = keypads;
+    traceLen = len > KEYPADTRACE_MAX_KEYPADS ? KEYPADTRACE_MAX_KEYPADS : len;
+    for (keypad = 0; keypad < KEYPADTRACE_MAX_KEYPADS; keypad++) {
+        traceActive[keypad] = 0;
+        for (outIndex = 0; outIndex < KEYPADTRACE_MAX_OUT; outIndex++) {
+            traceFrame[keypad][outIndex] = 0;
+            tracePrevious[keypad][outIndex] = 0;
+        }
+    }
+    traceTick = 0;
+    traceRecordTick = 0;
+}
@@ -0,0 +1,79 @@
+/**
+ * @file KeyPadTrace.h
+ * @author Ali Mirghasemi (ali.mirghasemi1376@gmail.com)
+ * @brief record raw samples of keypads in compact binary stream and replay them on host
+ * @version 0.1.0
+ * @date 2026-10-17
+ * 
+ * @copyright Copyright (c) 2026
+ * 
+ */
+
+#ifndef _KEYPAD_TRACE_H_
+#define _KEYPAD_TRACE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif 
+
+#include "KeyPad.h"
+
+/******************************************************************************/
+/*                                Configuration                               */
+/******************************************************************************/
+
+/**
+ * @brief maximum number of traced keypads, must be 255 or less
+ */
+#define KEYPADTRACE_MAX_KEYPADS             4
+/**
+ * @brief maximum number of outputs of each traced keypad
+ */
+#define KEYPADTRACE_MAX_OUT                 8
+
+/******************************************************************************/
+
+/**
+ * @brief stream of trace is sequence of records, a record written when frame of a tick differ from previous tick
+ * record := varint(ticks from previous record) entry* KEYPADTRACE_END
+ * entry  := keypad index (1 byte), output index (1 byte), varint(changed inputs of output)
+ * varint is 7 bits in each byte, LSB first, bit 7 show next byte
+ * frame hold inputs that read active while only one output of keypad was active in the tick
+ */
+#define KEYPADTRACE_END                     0xFF
+/**
+ * @brief maximum size of a record
+ */
+#define KEYPADTRACE_RECORD_SIZE             (5 + KEYPADTRACE_MAX_KEYPADS * KEYPADTRACE_MAX_OUT * (2 + (sizeof(KeyPad_PortMask) * 8 + 6) / 7) + 1)
+
+/**
+ * @brief traced keypad, index of it in table is index of keypad in stream
+ */
+typedef struct {
+    const KeyPad_Config*        Config;
+    KeyPad_ActiveState          ActiveState;
+} KeyPadTrace_KeyPad;
+
+/**
+ * @brief receive a record of stream, ex: write it into flash or uart
+ */
+typedef void (*KeyPadTrace_SinkFn)(const uint8_t* data, uint16_t len);
+
+/**
+ * @brief replay driver, pass it to KeyPad_init after KeyPadTrace_replay
+ * inputs return level of recorded frames
+ */
+extern const KeyPad_Driver KeyPadTrace_replayDriver;
+
+const KeyPad_Driver* KeyPadTrace_record(const KeyPad_Driver* driver, const KeyPadTrace_KeyPad* keypads, uint8_t len, KeyPadTrace_SinkFn sink);
+void KeyPadTrace_endTick(void);
+
+void KeyPadTrace_replay(const KeyPadTrace_KeyPad* keypads, uint8_t len, const uint8_t* data, uint32_t size);
+uint8_t KeyPadTrace_step(void);
+uint32_t KeyPadTrace_getTick(void);
+
+#ifdef __cplusplus
+};
+#endif
+
+#endif /* _KEYPAD_TRACE_H_ */
@@ -1,18 +1,150 @@
 #include "KeyPad.h"
 
 /* private variables */
-static const KeyPad_Driver* keypadDriver;
+#if KEYPAD_SHARD
+    static KeyPad_Context keypadContext = {0};              /**< default context of KeyPad_init, KeyPad_add and KeyPad_handle */
+
+    #define __defaultContext()  (&keypadContext)
+    #define __defaultDriver()   keypadContext.Driver
+    #define __driver(K)         (K)->Context->Driver
+    #define __context(K)        (K)->Context
+    #define __actives(C)        (C)->Active
+    #define __activesLen(C)     (C)->ActiveLen
+#else
+    static const KeyPad_Driver* keypadDriver;
+
+    #define __defaultDriver()   keypadDriver
+    #define __driver(K)         keypadDriver
+#endif // KEYPAD_SHARD
 #if KEYPAD_MAX_NUM == -1
     static KeyPad* lastKeyPad = KEYPAD_NULL;
 
-    #define __keypads()         lastKeyPad
-    #define __next(K)           K = (K)->Previous
+    #define __forEachKeyPad(K)  for ((K) = __load(lastKeyPad); KEYPAD_NULL != (K); (K) = __load((K)->Previous))
 #else
     static KeyPad keypads[KEYPAD_MAX_NUM] = {0};
+#if !KEYPAD_SHARD
+    static KeyPad* keypadsActive[KEYPAD_MAX_NUM];           /**< dense list of added keypads */
+    static KeyPad_NumType keypadsActiveLen = 0;
+
+    // one list without KEYPAD_SHARD, context argument is ignored
+    #define __defaultContext()  0
+    #define __context(K)        0
+    #define __actives(C)        keypadsActive
+    #define __activesLen(C)     keypadsActiveLen
+#endif // !KEYPAD_SHARD
+    static uint32_t keypadsUsed[(KEYPAD_MAX_NUM + 31) / 32] = {0}; /**< bit of each slot of keypads that returned by KeyPad_new, shared by all contexts */
+
+    #define __forEachKeyPad(K)  for (KeyPad_NumType __index = 0; __index < __activesLen(__defaultContext()) && ((K) = __actives(__defaultContext())[__index]) != KEYPAD_NULL; __index++)
+#endif // KEYPAD_MAX_NUM == -1
+#if KEYPAD_SCAN_BUDGET
+#if KEYPAD_MAX_NUM == -1
+    static KeyPad* scanKeyPad = KEYPAD_NULL;                /**< next keypad that scan, null show end of list */
+
+    #define __scanBegin()       scanKeyPad = lastKeyPad
+    #define __scanEnd()         (KEYPAD_NULL == scanKeyPad)
+    #define __scanKeyPad()      scanKeyPad
+    #define __scanNext()        scanKeyPad = scanKeyPad->Previous
+#else
+    static KeyPad_NumType scanIndex = 0;                    /**< index of next keypad that scan in active list */
 
-    #define __keypads()         keypads
-    #define __next(K)           K++
+    #define __scanBegin()       scanIndex = 0
+    #define __scanEnd()         (scanIndex >= __activesLen(__defaultContext()))
+    #define __scanKeyPad()      __actives(__defaultContext())[scanIndex]
+    #define __scanNext()        scanIndex++
 #endif // KEYPAD_MAX_NUM == -1
+    static uint8_t scanAdvanced = 0;                        /**< KeyPad_remove moved cursor to next keypad while KeyPad_handle scan it */
+#if KEYPAD_IDLE_WAKE
+    static uint8_t scanIdle = 1;                            /**< show all scanned keypads in current round are idle */
+#endif // KEYPAD_IDLE_WAKE
+#endif // KEYPAD_SCAN_BUDGET
+#if KEYPAD_IDLE_WAKE
+    static uint8_t keypadIdle = 0;
+    static volatile uint8_t keypadWake = 0;
+#endif // KEYPAD_IDLE_WAKE
+#if (KEYPAD_EVENT_QUEUE && !KEYPAD_SHARD) || KEYPAD_ADAPTIVE_RATE
+    static KeyPad_Tick keypadTick = 0;                      /**< tick of current KeyPad_handle */
+#endif // (KEYPAD_EVENT_QUEUE && !KEYPAD_SHARD) || KEYPAD_ADAPTIVE_RATE
+#if KEYPAD_ADAPTIVE_RATE
+    static uint16_t keypadElapsed = 1;                      /**< ticks from previous KeyPad_handle */
+
+    #define __elapsed()                 keypadElapsed
+#else
+    #define __elapsed()                 1
+#endif // KEYPAD_ADAPTIVE_RATE
+#if KEYPAD_EVENT_QUEUE
+#if KEYPAD_SHARD
+    #define __events()                  (&keypadContext.Shard.Queue)
+    #define __queue(K)                  (&(K)->Shard->Queue)
+    #define __tick(K)                   (K)->Shard->Tick
+    #define __setShard(K, S)            (K)->Shard = (S)
+#else
+    static KeyPad_EventQueue events = {0};                  /**< only KeyPad_handle push and only KeyPad_dispatch pop */
+
+    #define __events()                  (&events)
+    #define __queue(K)                  (&events)
+    #define __tick(K)                   keypadTick
+#endif // KEYPAD_SHARD
+    #if (KEYPAD_EVENT_QUEUE_SIZE & (KEYPAD_EVENT_QUEUE_SIZE - 1)) != 0
+        #error "KEYPAD_EVENT_QUEUE_SIZE must be power of 2"
+    #endif
+#endif // KEYPAD_EVENT_QUEUE
+#if !KEYPAD_SHARD || !KEYPAD_EVENT_QUEUE
+    #define __setShard(K, S)
+#endif // !KEYPAD_SHARD || !KEYPAD_EVENT_QUEUE
+#if KEYPAD_SCAN_GROUP && (!KEYPAD_NKRO || KEYPAD_SCAN_BUDGET)
+    #error "KEYPAD_SCAN_GROUP need KEYPAD_NKRO and not support KEYPAD_SCAN_BUDGET"
+#endif
+#if KEYPAD_SCAN_PIPELINE && (KEYPAD_SCAN_BUDGET || KEYPAD_SCAN_GROUP)
+    #error "KEYPAD_SCAN_PIPELINE not support KEYPAD_SCAN_BUDGET and KEYPAD_SCAN_GROUP"
+#endif
+#if KEYPAD_ANALOG && KEYPAD_NKRO
+    #error "KEYPAD_ANALOG not support KEYPAD_NKRO"
+#endif
+#if KEYPAD_CHORD && !KEYPAD_NKRO
+    #error "KEYPAD_CHORD need KEYPAD_NKRO"
+#endif
+#if KEYPAD_SHARD && (KEYPAD_MAX_NUM <= 0 || KEYPAD_SCAN_BUDGET || KEYPAD_SCAN_GROUP || KEYPAD_ADAPTIVE_RATE || KEYPAD_STATS)
+    #error "KEYPAD_SHARD need KEYPAD_MAX_NUM > 0 and not support KEYPAD_SCAN_BUDGET, KEYPAD_SCAN_GROUP, KEYPAD_ADAPTIVE_RATE and KEYPAD_STATS"
+#endif
+#if KEYPAD_FRAME_CAPTURE && !KEYPAD_NKRO
+    #error "KEYPAD_FRAME_CAPTURE need KEYPAD_NKRO"
+#endif
+#if KEYPAD_MAX_LEN > 32767 || KEYPAD_MAX_KEY_VALUE > 32767
+    #error "KEYPAD_MAX_LEN and KEYPAD_MAX_KEY_VALUE must be at most 32767"
+#endif
+#if KEYPAD_NKRO && KEYPAD_NKRO_MAX_OUT > KEYPAD_MAX_LEN
+    #error "KEYPAD_NKRO_MAX_OUT must be at most KEYPAD_MAX_LEN"
+#endif
+#if KEYPAD_CONCURRENT
+#if KEYPAD_MAX_NUM != -1 || KEYPAD_SCAN_BUDGET || KEYPAD_SCAN_GROUP
+    #error "KEYPAD_CONCURRENT need KEYPAD_MAX_NUM -1 and not support KEYPAD_SCAN_BUDGET and KEYPAD_SCAN_GROUP"
+#endif
+#if (KEYPAD_RETIRE_SIZE & (KEYPAD_RETIRE_SIZE - 1)) != 0
+    #error "KEYPAD_RETIRE_SIZE must be power of 2"
+#endif
+    static uint32_t keypadHandleSeq = 0;                    /**< odd while KeyPad_handle is running, only KeyPad_handle change it */
+    static KeyPad* keypadsRetired[KEYPAD_RETIRE_SIZE];      /**< removed keypads that running KeyPad_handle maybe point to them */
+    static uint8_t retiredHead = 0;                         /**< only KeyPad_remove change it */
+    static uint8_t retiredTail = 0;                         /**< only KeyPad_handle change it */
+
+    // shared fields have one writer context, writer publish them with release and other context read them with acquire
+    #define __load(X)                   KEYPAD_LOAD_ACQUIRE(X)
+    #define __publish(X, V)             KEYPAD_STORE_RELEASE(X, V)
+    // read-modify-write of seq is ordered, KeyPad_retire read it after unlink or KeyPad_handle see the unlink
+    #define __handleBegin()             KEYPAD_FETCH_ADD(keypadHandleSeq, 1)
+    #define __handleEnd()               KeyPad_reclaim(); KEYPAD_FETCH_ADD(keypadHandleSeq, 1)
+#else
+    #define __load(X)                   (X)
+    #define __publish(X, V)             (X) = (V)
+    #define __handleBegin()
+    #define __handleEnd()
+#endif // KEYPAD_CONCURRENT
+#if KEYPAD_STATS
+    static const KeyPad_Stats keypadStatsEmpty = {0};
+    static KeyPad_Stats keypadStats = {0};
+    static KeyPad_GetCyclesFn keypadClock = 0;
+    static uint32_t keypadHandleStart = 0;                  /**< user clock at start of current KeyPad_handle */
+#endif // KEYPAD_STATS
 
 #if KEYPAD_ACTIVE_STATE
     #define __activeState(K)            (K)->ActiveState
@@ -20,50 +152,241 @@ static const KeyPad_Driver* keypadDriver;
     #define __activeState(K)            KeyPad_ActiveState_Low
 #endif
 
+#if KEYPAD_ENABLE_FLAG
+    #define __isEnabled(K)              (K)->Enabled
+#else
+    #define __isEnabled(K)              1
+#endif // KEYPAD_ENABLE_FLAG
+
+#if KEYPAD_CONCURRENT
+    // keypad that KeyPad_remove accepted, or released one that its events still in queue
+    #define __isRemoved(K)              (__load((K)->Retired) || !__load((K)->Configured))
+#else
+    #define __isRemoved(K)              0
+#endif // KEYPAD_CONCURRENT
+
+#if KEYPAD_SHARED_CALLBACKS
+    #define __callbacks(K)              (*(K)->Callbacks)
+    static const KeyPad_Callbacks keypadCallbacksNone = {{0}};
+#else
+    #define __callbacks(K)              (K)->Callbacks
+#endif // KEYPAD_SHARED_CALLBACKS
+
 #define __inPinMode(K)                  ((KeyPad_PinMode) __activeState(K))
 #define __outPinMode(K)                 KeyPad_PinMode_Output
 
+#define __INDEX_NONE                    ((KeyPad_LenType) -1)
+
+#define __portMask(LEN)                 ((LEN) >= (KeyPad_LenType) (sizeof(KeyPad_PortMask) * 8) ? (KeyPad_PortMask) ~0 : \
+                                            (((KeyPad_PortMask) 1 << (LEN)) - 1))
+
 #if KEYPAD_MODE == KEYPAD_MODE_ROW_INPUT    
+    #define __configOutNum(C)           (C)->ColumnsLen
+    #define __configInNum(C)            (C)->RowsLen
     #define __outNum(K)                 (K)->Config->ColumnsLen
     #define __inNum(K)                  (K)->Config->RowsLen
     #define __outPin(K,I)               (K)->Config->Columns[I]
     #define __inPin(K,I)                (K)->Config->Rows[I]
-    #define __value(K, OUT, IN)         *((K)->Config->Map + (IN * (K)->Config->ColumnsLen) + (OUT))
+    #define __value(K, OUT, IN)         (K)->Config->Map[__keyIndex(K, OUT, IN)]
+    #define __keyIndex(K, OUT, IN)      ((KeyPad_KeyIndex) (IN) * (KeyPad_KeyIndex) (K)->Config->ColumnsLen + (KeyPad_KeyIndex) (OUT))
+    #define __keyOut(K, KEY)            ((KEY) % (K)->Config->ColumnsLen)
+    #define __keyIn(K, KEY)             ((KEY) / (K)->Config->ColumnsLen)
     #define __setOutIndex(K, IDX)       (K)->ColIndex = (IDX)
     #define __setInIndex(K, IDX)        (K)->RowIndex = (IDX)
     #define __getOutIndex(K)            (K)->ColIndex
     #define __getInIndex(K)             (K)->RowIndex
 #else
+    #define __configOutNum(C)           (C)->RowsLen
+    #define __configInNum(C)            (C)->ColumnsLen
     #define __outNum(K)                 (K)->Config->RowsLen
     #define __inNum(K)                  (K)->Config->ColumnsLen
     #define __outPin(K,I)               (K)->Config->Rows[I]
     #define __inPin(K,I)                (K)->Config->Columns[I]
-    #define __value(K, OUT, IN)         *((K)->Config->Map + (OUT * (K)->Config->ColumnsLen) + (IN))
+    #define __value(K, OUT, IN)         (K)->Config->Map[__keyIndex(K, OUT, IN)]
+    #define __keyIndex(K, OUT, IN)      ((KeyPad_KeyIndex) (OUT) * (KeyPad_KeyIndex) (K)->Config->ColumnsLen + (KeyPad_KeyIndex) (IN))
+    #define __keyOut(K, KEY)            ((KEY) / (K)->Config->ColumnsLen)
+    #define __keyIn(K, KEY)             ((KEY) % (K)->Config->ColumnsLen)
     #define __setOutIndex(K, IDX)       (K)->RowIndex = (IDX)
     #define __setInIndex(K, IDX)        (K)->ColIndex = (IDX)
     #define __getOutIndex(K)            (K)->RowIndex
     #define __getInIndex(K)             (K)->ColIndex
 #endif
 
-#if KEYPAD_MULTI_CALLBACK
-    #define __fireCallback(K, VALUE)            if ((K)->Callbacks.fn[(K)->State]) (K)->NotActive = (K)->Callbacks.fn[(K)->State]((K), (VALUE), (KeyPad_State) (K)->State)
+#if KEYPAD_NKRO
+    // frame of nkro keypad hold KEYPAD_NKRO_MAX_OUT outputs and bits of KeyPad_PortMask inputs
+    #define __configFits(C)             (__configOutNum(C) <= KEYPAD_NKRO_MAX_OUT && \
+                                            __configInNum(C) <= (KeyPad_LenType) (sizeof(KeyPad_PortMask) * 8))
+#else
+    #define __configFits(C)             1
+#endif // KEYPAD_NKRO
+
+#if KEYPAD_STATS
+    #define __count(K, FIELD)           ((K)->Stats.FIELD++, keypadStats.Counters.FIELD++)
+#if KEYPAD_EVENT_QUEUE
+    #define __pressLatency()
+#else
+    #define __pressLatency()            if (keypadClock) KeyPad_sample(&keypadStats.Latency, keypadClock() - keypadHandleStart)
+#endif // KEYPAD_EVENT_QUEUE
+#else
+    #define __count(K, FIELD)           ((void) 0)
+    #define __pressLatency()
+#endif // KEYPAD_STATS
+
+#define __readPin(K, C)                 (__count(K, Reads), __driver(K)->readPin(C))
+#define __writePin(K, C, V)             (__count(K, Writes), __driver(K)->writePin((C), (V)))
+#define __readPort(K, C, L)             (__count(K, Reads), __driver(K)->readPort((C), (L)))
+#define __writePort(K, C, L, V)         (__count(K, Writes), __driver(K)->writePort((C), (L), (V)))
+// outputs or inputs more than bits of KeyPad_PortMask use pin functions
+#define __useWritePort(K)               (__driver(K)->writePort && __outNum(K) <= (KeyPad_LenType) (sizeof(KeyPad_PortMask) * 8))
+#define __useReadPort(K)                (__driver(K)->readPort && __inNum(K) <= (KeyPad_LenType) (sizeof(KeyPad_PortMask) * 8))
+
+#if KEYPAD_ANALOG
+    #define __isAnalog(K)               ((K)->Config->Thresholds != 0)
+    #define __readAnalog(K, C)          (__count(K, Reads), __driver(K)->readAnalog(C))
+#else
+    #define __isAnalog(K)               0
+#endif // KEYPAD_ANALOG
+
+#if KEYPAD_DEBOUNCE
+    #define __DEBOUNCE_COUNT            (1 << KEYPAD_DEBOUNCE_BITS)
+    #define __needScan(K)               ((K)->State == KeyPad_State_None && (K)->Debounce == 0)
+#else
+    #define __needScan(K)               ((K)->State == KeyPad_State_None)
+#endif // KEYPAD_DEBOUNCE
+
+#if KEYPAD_EVENT_QUEUE
+    #define __fireEvent(K, VALUE, STATE)        KeyPad_pushEvent((K), __getOutIndex(K), __getInIndex(K), (VALUE), (STATE))
+#if KEYPAD_NONE_CALLBACK
+    #define __fireNoneCallback(K)               if ((K)->State == KeyPad_State_None) KeyPad_pushEvent((K), __INDEX_NONE, __INDEX_NONE, KEYPAD_KEY_NONE, KeyPad_State_None)
+#else
+    #define __fireNoneCallback(K)
+#endif
+#elif KEYPAD_MULTI_CALLBACK
+    #define __fireEvent(K, VALUE, STATE)        if (!__isRemoved(K) && __callbacks(K).fn[(STATE)]) (K)->NotActive = (__count(K, Callbacks), __callbacks(K).fn[(STATE)]((K), (VALUE), (STATE)))
 #if KEYPAD_NONE_CALLBACK
-    #define __fireNoneCallback(K)               if ((K)->State == KeyPad_State_None && (K)->Callbacks.onNone) (K)->NotActive = (K)->Callbacks.onNone((K), KEYPAD_KEY_NONE, KeyPad_State_None)
+    #define __fireNoneCallback(K)               if ((K)->State == KeyPad_State_None && !__isRemoved(K) && __callbacks(K).onNone) (K)->NotActive = (__count(K, Callbacks), __callbacks(K).onNone((K), KEYPAD_KEY_NONE, KeyPad_State_None))
 #else
     #define __fireNoneCallback(K)            
 #endif
 #else
-    #define __fireCallback(K, VALUE)            if ((K)->Callbacks.onChange) (K)->NotActive = (K)->Callbacks.onChange((K), (VALUE), (KeyPad_State) (K)->State)
+    #define __fireEvent(K, VALUE, STATE)        if (!__isRemoved(K) && __callbacks(K).onChange) (K)->NotActive = (__count(K, Callbacks), __callbacks(K).onChange((K), (VALUE), (STATE)))
 #if KEYPAD_NONE_CALLBACK
-    #define __fireNoneCallback(K)               if ((K)->State == KeyPad_State_None && (K)->Callbacks.onChange) (K)->NotActive = (K)->Callbacks.onNone((K), KEYPAD_KEY_NONE, KeyPad_State_None)
+    #define __fireNoneCallback(K)               if ((K)->State == KeyPad_State_None && !__isRemoved(K) && __callbacks(K).onChange) (K)->NotActive = (__count(K, Callbacks), __callbacks(K).onChange((K), KEYPAD_KEY_NONE, KeyPad_State_None))
 #else
     #define __fireNoneCallback(K)            
 #endif
-#endif // KEYPAD_MULTI_CALLBACK
+#endif // KEYPAD_EVENT_QUEUE
+#define __fireCallback(K, VALUE)                __fireEvent((K), (VALUE), (KeyPad_State) (K)->State)
+
+#if KEYPAD_HOLD_REPEAT
+    #define __resetHold(K)                      (K)->HoldTicks = 0; (K)->LongPressed = 0
+#else
+    #define __resetHold(K)
+#endif // KEYPAD_HOLD_REPEAT
 
+static void KeyPad_runHandle(void);
+static void KeyPad_handleKeyPads(void);
+#if !KEYPAD_SCAN_BUDGET
+static void KeyPad_scanKeyPad(KeyPad* keypad);
+#endif // !KEYPAD_SCAN_BUDGET
+#if KEYPAD_CONCURRENT
+static void KeyPad_retire(KeyPad* keypad);
+static void KeyPad_reclaim(void);
+static void KeyPad_release(KeyPad* keypad);
+static void KeyPad_applyConfig(KeyPad* keypad);
+#endif // KEYPAD_CONCURRENT
 static void KeyPad_initOut(KeyPad* keypad);
 static void KeyPad_initIn(KeyPad* keypad);
+#if KEYPAD_USE_DEINIT
+static void KeyPad_deinitPins(KeyPad* keypad);
+#endif // KEYPAD_USE_DEINIT
+static void KeyPad_writeOut(KeyPad* keypad, KeyPad_LenType outIndex, uint8_t value);
+#if KEYPAD_USE_PORT
+static void KeyPad_writeOuts(KeyPad* keypad, KeyPad_PortMask value);
+#endif // KEYPAD_USE_PORT
+static void KeyPad_strobeOut(KeyPad* keypad, KeyPad_LenType outIndex, uint8_t state);
+static void KeyPad_releaseOut(KeyPad* keypad, KeyPad_LenType outIndex, uint8_t state);
+static void KeyPad_endStrobe(KeyPad* keypad, uint8_t state);
+#if KEYPAD_DEBOUNCE && (KEYPAD_IDLE_WAKE || KEYPAD_ADAPTIVE_RATE)
+static uint8_t KeyPad_isDebouncing(KeyPad* keypad);
+#endif // KEYPAD_DEBOUNCE && (KEYPAD_IDLE_WAKE || KEYPAD_ADAPTIVE_RATE)
+#if KEYPAD_IDLE_WAKE || KEYPAD_ADAPTIVE_RATE
+static uint8_t KeyPad_isStable(KeyPad* keypad);
+#endif // KEYPAD_IDLE_WAKE || KEYPAD_ADAPTIVE_RATE
+#if KEYPAD_ADAPTIVE_RATE
+static KeyPad_Tick KeyPad_nextPeriod(void);
+static KeyPad_Tick KeyPad_period(KeyPad* keypad);
+#endif // KEYPAD_ADAPTIVE_RATE
+#if KEYPAD_IDLE_WAKE
+static void KeyPad_setIdle(uint8_t enable);
+static uint8_t KeyPad_setIdleAll(uint8_t enable);
+static uint8_t KeyPad_setIdleKeyPad(KeyPad* keypad, uint8_t enable);
+#endif // KEYPAD_IDLE_WAKE
+#if KEYPAD_NKRO
+static KeyPad_PortMask KeyPad_readIn(KeyPad* keypad, uint8_t state);
+#if !KEYPAD_SCAN_BUDGET
+static void KeyPad_scanFrame(KeyPad* keypad);
+#endif // !KEYPAD_SCAN_BUDGET
+#if !KEYPAD_SCAN_GROUP
+static KeyPad_PortMask KeyPad_readOut(KeyPad* keypad, KeyPad_LenType outIndex, uint8_t state);
+static void KeyPad_endFrame(KeyPad* keypad, KeyPad_PortMask* frame, uint8_t state);
+#endif // !KEYPAD_SCAN_GROUP
+static void KeyPad_applyFrame(KeyPad* keypad, KeyPad_PortMask* frame);
+static void KeyPad_resetFrame(KeyPad* keypad);
+#if KEYPAD_SCAN_GROUP
+static void KeyPad_scanGroup(KeyPad* keypad);
+static void KeyPad_joinGroup(KeyPad* keypad);
+static void KeyPad_leaveGroup(KeyPad* keypad);
+#endif // KEYPAD_SCAN_GROUP
+static void KeyPad_updateFrame(KeyPad* keypad, KeyPad_PortMask* frame);
+static void KeyPad_fireKey(KeyPad* keypad, KeyPad_LenType outIndex, KeyPad_LenType inIndex, KeyPad_State state);
+#if KEYPAD_DEBOUNCE
+static void KeyPad_debounceFrame(KeyPad* keypad, KeyPad_PortMask* frame);
+#endif // KEYPAD_DEBOUNCE
+#if KEYPAD_CHORD
+static uint8_t KeyPad_chordKey(KeyPad* keypad, KeyPad_LenType outIndex, KeyPad_LenType inIndex, KeyPad_State state);
+static void KeyPad_matchChord(KeyPad* keypad);
+static void KeyPad_flushChord(KeyPad* keypad);
+static void KeyPad_fireChord(KeyPad* keypad, uint8_t index, KeyPad_State state);
+static void KeyPad_callChord(KeyPad* keypad, KeyPad_KeyValue value, KeyPad_State state);
+static KeyPad_ChordRules KeyPad_chordRules(const KeyPad_Chords* chords, KeyPad_ChordMask keys);
+#endif // KEYPAD_CHORD
+#else
+#if !KEYPAD_SCAN_BUDGET
 static void KeyPad_scanKeys(KeyPad* keypad);
+#endif // !KEYPAD_SCAN_BUDGET
+static uint8_t KeyPad_scanOut(KeyPad* keypad, KeyPad_LenType outIndex, uint8_t state);
+static uint8_t KeyPad_sampleOut(KeyPad* keypad, KeyPad_LenType outIndex, uint8_t state);
+static void KeyPad_pressKey(KeyPad* keypad, KeyPad_LenType outIndex, KeyPad_LenType inIndex);
+static void KeyPad_checkKey(KeyPad* keypad);
+static KeyPad_LenType KeyPad_findIn(KeyPad* keypad, uint8_t state);
+#if KEYPAD_ANALOG
+static void KeyPad_scanLevels(KeyPad* keypad);
+static KeyPad_LenType KeyPad_findLevel(KeyPad* keypad, KeyPad_AnalogValue value);
+static uint8_t KeyPad_inLevel(KeyPad* keypad, KeyPad_LenType level, KeyPad_AnalogValue value);
+#endif // KEYPAD_ANALOG
+#endif // KEYPAD_NKRO
+#if KEYPAD_SCAN_BUDGET
+static uint8_t KeyPad_scanStep(KeyPad* keypad);
+#endif // KEYPAD_SCAN_BUDGET
+#if KEYPAD_SCAN_PIPELINE
+static void KeyPad_pipeStep(KeyPad* keypad);
+static void KeyPad_pipeStrobe(KeyPad* keypad, uint8_t state);
+#endif // KEYPAD_SCAN_PIPELINE
+#if KEYPAD_HOLD_REPEAT
+static KeyPad_State KeyPad_holdEvent(KeyPad* keypad);
+#endif // KEYPAD_HOLD_REPEAT
+#if KEYPAD_NKRO || KEYPAD_EVENT_QUEUE
+static void KeyPad_callKey(KeyPad* keypad, KeyPad_LenType outIndex, KeyPad_LenType inIndex, KeyPad_KeyValue value, KeyPad_State state);
+static KeyPad_HandleStatus KeyPad_callback(KeyPad* keypad, KeyPad_KeyValue value, KeyPad_State state);
+#endif // KEYPAD_NKRO || KEYPAD_EVENT_QUEUE
+#if KEYPAD_EVENT_QUEUE
+static void KeyPad_pushEvent(KeyPad* keypad, KeyPad_LenType outIndex, KeyPad_LenType inIndex, KeyPad_KeyValue value, KeyPad_State state);
+static uint16_t KeyPad_dispatchQueue(KeyPad_EventQueue* queue);
+#endif // KEYPAD_EVENT_QUEUE
+#if KEYPAD_STATS
+static void KeyPad_sample(KeyPad_Histogram* histogram, uint32_t cycles);
+#endif // KEYPAD_STATS
 
 /**
  * @brief use for initialize
@@ -71,67 +394,363 @@ static void KeyPad_scanKeys(KeyPad* keypad);
  * @param driver 
  */
 void KeyPad_init(const KeyPad_Driver* driver) {
-    keypadDriver = driver;
+    __defaultDriver() = driver;
 }
 /**
  * @brief user must place it in timer with 20ms ~ 50ms 
  * all of callbacks handle and fire in this function
  */
 void KeyPad_handle(void) {
-    KeyPad* pKeyPad = __keypads();
+#if KEYPAD_SHARD && KEYPAD_EVENT_QUEUE
+    keypadContext.Shard.Tick++;
+#elif KEYPAD_EVENT_QUEUE || KEYPAD_ADAPTIVE_RATE
+    keypadTick++;
+#endif // KEYPAD_SHARD && KEYPAD_EVENT_QUEUE
+#if KEYPAD_ADAPTIVE_RATE
+    keypadElapsed = 1;
+#endif // KEYPAD_ADAPTIVE_RATE
+    __handleBegin();
+    KeyPad_runHandle();
+    __handleEnd();
+}
+#if KEYPAD_ADAPTIVE_RATE
+/**
+ * @brief same as KeyPad_handle but user pass current tick, ex: ms of rtos
+ * it's poll slowly when no key is pressed, fast while keys changing and in hold period or next long press/repeat while keys hold
+ * in idle mode user must call it again after KeyPad_wake
+ * 
+ * @param now current tick
+ * @return KeyPad_Tick tick that KeyPad_handleAt must call again
+ */
+KeyPad_Tick KeyPad_handleAt(KeyPad_Tick now) {
+    KeyPad_Tick elapsed = now - keypadTick;
+    keypadElapsed = elapsed > 0xFFFF ? 0xFFFF : (uint16_t) elapsed;
+    keypadTick = now;
+    __handleBegin();
+    KeyPad_runHandle();
+    elapsed = KeyPad_nextPeriod();
+    __handleEnd();
+    return now + elapsed;
+}
+#endif // KEYPAD_ADAPTIVE_RATE
+/**
+ * @brief run handle of keypads and record its duration
+ */
+static void KeyPad_runHandle(void) {
+#if KEYPAD_STATS
+    if (keypadClock) {
+        keypadHandleStart = keypadClock();
+        KeyPad_handleKeyPads();
+        KeyPad_sample(&keypadStats.Handle, keypadClock() - keypadHandleStart);
+        return;
+    }
+#endif // KEYPAD_STATS
+    KeyPad_handleKeyPads();
+}
+/**
+ * @brief scan keypads and fire callbacks, body of KeyPad_handle
+ */
+static void KeyPad_handleKeyPads(void) {
+    KeyPad* pKeyPad;
+#if KEYPAD_SCAN_BUDGET
+    uint16_t budget = KEYPAD_SCAN_BUDGET;
+#elif KEYPAD_IDLE_WAKE
+    uint8_t idle = 1;
+#endif // KEYPAD_SCAN_BUDGET
 
-#if KEYPAD_MAX_NUM == -1
-    while (KEYPAD_NULL != pKeyPad) {
-#else
-    uint8_t len = KEYPAD_MAX_NUM;
-    while (len-- > 0) {
-        if (pKeyPad->Configured) {
-#endif
+#if KEYPAD_IDLE_WAKE
+    if (keypadIdle) {
+        if (!keypadWake) {
+            return;
+        }
+        // input edge detected, back to scan
+        KeyPad_setIdle(0);
+    }
+#endif // KEYPAD_IDLE_WAKE
+
+#if KEYPAD_SCAN_BUDGET
+    if (__scanEnd()) {
+        // start new round from first keypad
+        __scanBegin();
+    #if KEYPAD_IDLE_WAKE
+        scanIdle = 1;
+    #endif // KEYPAD_IDLE_WAKE
+    }
+    while (budget > 0 && !__scanEnd()) {
+        pKeyPad = __scanKeyPad();
+        scanAdvanced = 0;
     #if KEYPAD_ENABLE_FLAG
         if (pKeyPad->Enabled) {
     #endif // KEYPAD_ENABLE_FLAG
-
-        if (pKeyPad->State == KeyPad_State_None) {
-            // scan all keys
-            KeyPad_scanKeys(pKeyPad);
+        budget--;
+        __count(pKeyPad, Scans);
+        if (!KeyPad_scanStep(pKeyPad)) {
+            // scan of keypad continue in next step
+            continue;
         }
-        else {
-            // scan only pressed key
-            KeyPad_LenType outIndex = __getOutIndex(pKeyPad);
-            KeyPad_LenType inIndex = __getInIndex(pKeyPad);
-            uint8_t state = __activeState(keypad);
-            // check pressed key
-            pKeyPad->State = keypadDriver->readPin(&__inPin(pKeyPad, inIndex)) == state ? KeyPad_State_Hold :
-                                                                                        KeyPad_State_Released;
-            
-            if (!pKeyPad->NotActive) {
-              __fireCallback(pKeyPad, __value(pKeyPad, outIndex, inIndex));
-            }
-            
-            if (pKeyPad->State == KeyPad_State_Released) {
-                pKeyPad->State = KeyPad_State_None;
-                keypadDriver->writePin(&__outPin(pKeyPad, outIndex), !state);
-            }
+    #if KEYPAD_IDLE_WAKE
+        scanIdle &= KeyPad_isStable(pKeyPad);
+    #endif // KEYPAD_IDLE_WAKE
+    #if KEYPAD_ENABLE_FLAG
+        }
+    #endif // KEYPAD_ENABLE_FLAG
+        if (!scanAdvanced) {
+            // keypad not removed in its callbacks, otherwise cursor already point to next keypad
+            __scanNext();
+        }
+    }
+#if KEYPAD_IDLE_WAKE
+    if (__scanEnd() && scanIdle && __defaultDriver()->setWakePin) {
+        KeyPad_setIdle(1);
+    }
+#endif // KEYPAD_IDLE_WAKE
+#else
+    __forEachKeyPad(pKeyPad) {
+    #if KEYPAD_CONCURRENT
+        if (__load(pKeyPad->Retired)) {
+            // removed while handle run, keypad stay linked until handle end but it must not scan or fire
+            continue;
         }
+        KeyPad_applyConfig(pKeyPad);
+    #endif // KEYPAD_CONCURRENT
+    #if KEYPAD_ENABLE_FLAG
+        if (pKeyPad->Enabled) {
+    #endif // KEYPAD_ENABLE_FLAG
+        KeyPad_scanKeyPad(pKeyPad);
+    #if KEYPAD_IDLE_WAKE
+        idle &= KeyPad_isStable(pKeyPad);
+    #endif // KEYPAD_IDLE_WAKE
 
     #if KEYPAD_ENABLE_FLAG
         }
     #endif // KEYPAD_ENABLE_FLAG
-    #if KEYPAD_MAX_NUM > 0
+    }
+#if KEYPAD_IDLE_WAKE
+    if (idle && __defaultDriver()->setWakePin) {
+        KeyPad_setIdle(1);
+    }
+#endif // KEYPAD_IDLE_WAKE
+#endif // KEYPAD_SCAN_BUDGET
+}
+#if !KEYPAD_SCAN_BUDGET
+/**
+ * @brief scan a keypad and fire its changes
+ */
+static void KeyPad_scanKeyPad(KeyPad* keypad) {
+    __count(keypad, Scans);
+#if KEYPAD_SCAN_PIPELINE
+    if (keypad->Config->Settle) {
+        // scan an output, outputs of keypad settle between handles
+        KeyPad_pipeStep(keypad);
+    }
+    else
+#endif // KEYPAD_SCAN_PIPELINE
+#if KEYPAD_NKRO
+    // scan all keys and fire changes
+    KeyPad_scanFrame(keypad);
+#else
+    if (__needScan(keypad)) {
+        // scan all keys
+        KeyPad_scanKeys(keypad);
+    }
+    else {
+        // scan only pressed key
+        KeyPad_checkKey(keypad);
+    }
+#endif // KEYPAD_NKRO
+}
+#endif // !KEYPAD_SCAN_BUDGET
+#if KEYPAD_SHARD
+/**
+ * @brief init a context that keypads of it handle apart from keypads of default context
+ * 
+ * @param context 
+ * @param driver driver of keypads of context
+ */
+void KeyPad_initContext(KeyPad_Context* context, const KeyPad_Driver* driver) {
+    context->Driver = driver;
+    context->ActiveLen = 0;
+}
+/**
+ * @brief return default context, KeyPad_handleShard of its keypads need it
+ */
+KeyPad_Context* KeyPad_getContext(void) {
+    return &keypadContext;
+}
+/**
+ * @brief scan a block of keypads of context, each thread call it with its own shard instead of KeyPad_handle
+ * active keypads split into num contiguous blocks and shard scan block of its Index
+ * without KEYPAD_EVENT_QUEUE callbacks fire in thread of shard
+ * 
+ * @param context keypads and driver, it's read-only while shards running
+ * @param shard state of thread, events of its keypads push into its queue
+ * @param num number of shards of context
+ */
+void KeyPad_handleShard(KeyPad_Context* context, KeyPad_Shard* shard, KeyPad_NumType num) {
+    KeyPad* pKeyPad;
+    KeyPad_NumType len = context->ActiveLen;
+    KeyPad_NumType pos = (KeyPad_NumType) ((uint32_t) len * shard->Index / num);
+    KeyPad_NumType end = (KeyPad_NumType) ((uint32_t) len * (shard->Index + 1) / num);
+#if KEYPAD_EVENT_QUEUE
+    shard->Tick++;
+#endif // KEYPAD_EVENT_QUEUE
+    shard->Keypads = (KeyPad_NumType) (end - pos);
+    for (; pos < end; pos++) {
+        pKeyPad = context->Active[pos];
+        if (__isEnabled(pKeyPad)) {
+            __setShard(pKeyPad, shard);
+            KeyPad_scanKeyPad(pKeyPad);
+        }
+    }
+}
+#if KEYPAD_EVENT_QUEUE
+/**
+ * @brief fire callbacks of events of a shard, it's only consumer of queue of shard
+ * 
+ * @param shard 
+ * @return uint16_t number of dispatched events
+ */
+uint16_t KeyPad_dispatchShard(KeyPad_Shard* shard) {
+    return KeyPad_dispatchQueue(&shard->Queue);
+}
+#endif // KEYPAD_EVENT_QUEUE
+#endif // KEYPAD_SHARD
+#if KEYPAD_IDLE_WAKE
+/**
+ * @brief show all keypads are idle and KeyPad_handle don't scan them
+ * user can stop timer of KeyPad_handle until KeyPad_wake
+ * 
+ * @return uint8_t 1 if keypads are idle
+ */
+uint8_t KeyPad_isIdle(void) {
+    return keypadIdle;
+}
+/**
+ * @brief user must call it in edge interrupt of input pins
+ * next KeyPad_handle back to scan
+ */
+void KeyPad_wake(void) {
+    keypadWake = 1;
+}
+#endif // KEYPAD_IDLE_WAKE
+#if KEYPAD_EVENT_QUEUE
+/**
+ * @brief fire callbacks of events in queue, user can place it in main loop or another thread
+ * it's only consumer of queue and can run concurrent with KeyPad_handle
+ * 
+ * @return uint16_t number of dispatched events
+ */
+uint16_t KeyPad_dispatch(void) {
+    return KeyPad_dispatchQueue(__events());
+}
+/**
+ * @brief return number of events that dropped because queue was full
+ * counter never reset, compare it with previous value
+ * 
+ * @return uint32_t 
+ */
+uint32_t KeyPad_getOverflow(void) {
+    return __events()->Overflow;
+}
+/**
+ * @brief fire callbacks of events in a queue
+ * 
+ * @return uint16_t number of dispatched events
+ */
+static uint16_t KeyPad_dispatchQueue(KeyPad_EventQueue* queue) {
+    uint16_t count = 0;
+    uint16_t tail = queue->Tail;
+    while (tail != queue->Head) {
+        KeyPad_Event event;
+        KEYPAD_MEMORY_BARRIER();
+        event = queue->Events[tail & (KEYPAD_EVENT_QUEUE_SIZE - 1)];
+        KEYPAD_MEMORY_BARRIER();
+        queue->Tail = ++tail;
+    #if KEYPAD_STATS
+        if (event.State == KeyPad_State_Pressed && keypadClock) {
+            KeyPad_sample(&keypadStats.Latency, keypadClock() - event.Cycles);
+        }
+    #endif // KEYPAD_STATS
+    #if KEYPAD_CHORD
+        if (event.OutIndex == __INDEX_NONE && event.InIndex != __INDEX_NONE) {
+            KeyPad_callChord(event.Keypad, event.Value, (KeyPad_State) event.State);
         }
-    #endif // KEYPAD_MAX_NUM
-        __next(pKeyPad);
+        else
+    #endif // KEYPAD_CHORD
+        KeyPad_callKey(event.Keypad, event.OutIndex, event.InIndex, event.Value, (KeyPad_State) event.State);
+        count++;
+    }
+    return count;
+}
+#endif // KEYPAD_EVENT_QUEUE
+#if KEYPAD_STATS
+/**
+ * @brief set user clock for histograms, histograms not recorded while it's null
+ * 
+ * @param fn function that return free running counter, ex: DWT->CYCCNT
+ */
+void KeyPad_setStatsClock(KeyPad_GetCyclesFn fn) {
+    keypadClock = fn;
+}
+/**
+ * @brief return stats of library, counters are sum of all keypads
+ * 
+ * @return const KeyPad_Stats* 
+ */
+const KeyPad_Stats* KeyPad_getStats(void) {
+    return &keypadStats;
+}
+/**
+ * @brief return counters of a keypad
+ * 
+ * @param keypad 
+ * @return const KeyPad_Counters* 
+ */
+const KeyPad_Counters* KeyPad_getCounters(KeyPad* keypad) {
+    return &keypad->Stats;
+}
+/**
+ * @brief reset stats of library and counters of all keypads
+ */
+void KeyPad_resetStats(void) {
+    KeyPad* pKeyPad;
+    keypadStats = keypadStatsEmpty;
+    __forEachKeyPad(pKeyPad) {
+        pKeyPad->Stats = keypadStatsEmpty.Counters;
     }
 }
+#endif // KEYPAD_STATS
 
 /**
  * @brief set new pin configuration for keypad
  * 
+ * in nkro mode config that has more than KEYPAD_NKRO_MAX_OUT outputs or more inputs than bits of KeyPad_PortMask ignored
+ * 
  * @param keypad address of keypad instance
  * @param config new pin configuration
  */
 void KeyPad_setConfig(KeyPad* keypad, const KeyPad_Config* config) {
-    keypad->Config = config;
+    if (!__configFits(config)) {
+        // frame of keypad can't hold all keys, keep old config
+        return;
+    }
+#if KEYPAD_CONCURRENT
+    __publish(keypad->NewConfig, config);
+    if (__load(keypad->Configured)) {
+        // KeyPad_handle maybe scan keypad now, it apply config before a scan that no key is pressed
+        return;
+    }
+#endif // KEYPAD_CONCURRENT
+#if KEYPAD_SCAN_GROUP
+    if (keypad->Configured) {
+        // outputs maybe changed
+        KeyPad_leaveGroup(keypad);
+        keypad->Config = config;
+        KeyPad_joinGroup(keypad);
+        return;
+    }
+#endif // KEYPAD_SCAN_GROUP
+    __publish(keypad->Config, config);
 }
 /**
  * @brief get keypad pin config
@@ -140,7 +759,7 @@ void KeyPad_setConfig(KeyPad* keypad, const KeyPad_Config* config) {
  * @return const KeyPad_PinConfig* 
  */
 const KeyPad_Config* KeyPad_getConfig(KeyPad* keypad) {
-    return keypad->Config;
+    return __load(keypad->Config);
 }
 #if KEYPAD_MAX_NUM > 0
 /**
@@ -149,42 +768,152 @@ const KeyPad_Config* KeyPad_getConfig(KeyPad* keypad) {
  * @return KeyPad* return null if not found empty space
  */
 KeyPad* KeyPad_new(void) {
-    uint8_t len = KEYPAD_MAX_NUM;
-    KeyPad* pKeyPad = keypads;
-    while (len--) {
-        if (pKeyPad->Configured) {
-            return pKeyPad;
+    uint16_t wordIndex;
+    for (wordIndex = 0; wordIndex < (KEYPAD_MAX_NUM + 31) / 32; wordIndex++) {
+        uint32_t word = ~keypadsUsed[wordIndex];
+        if (word) {
+            uint16_t index = (uint16_t) (wordIndex * 32 + KEYPAD_CTZ(word));
+            if (index >= KEYPAD_MAX_NUM) {
+                break;
+            }
+            keypadsUsed[wordIndex] |= (uint32_t) 1 << (index & 31);
+            return &keypads[index];
         }
-        pKeyPad++;
     }
     return KEYPAD_NULL;
 }
 #endif // KEYPAD_MAX_NUM
+#if KEYPAD_SHARD
+/**
+ * @brief add keypad into list of default context
+ */
+uint8_t KeyPad_add(KeyPad* keypad, const KeyPad_Config* config) {
+    return KeyPad_addContext(&keypadContext, keypad, config);
+}
+/**
+ * @brief add keypad into list of a context for process, keypad can be in one context
+ * 
+ * @param context
+ * @param keypad address of keypad
+ * @param config keypad pin configuration
+ * @return uint8_t 0 if keypad is null, list is full, keypad is in other context or in nkro mode config has more than KEYPAD_NKRO_MAX_OUT outputs
+ * or more inputs than bits of KeyPad_PortMask
+ */
+uint8_t KeyPad_addContext(KeyPad_Context* context, KeyPad* keypad, const KeyPad_Config* config) {
+#else
 /**
  * @brief add keypad into list for process
  * 
  * @param keypad address of keypad
  * @param config keypad pin configuration
+ * @return uint8_t 0 if keypad is null, list is full or in nkro mode config has more than KEYPAD_NKRO_MAX_OUT outputs
+ * or more inputs than bits of KeyPad_PortMask
  */
 uint8_t KeyPad_add(KeyPad* keypad, const KeyPad_Config* config) {
+#endif // KEYPAD_SHARD
     // check for null
     if (KEYPAD_NULL == keypad) {
         return 0;
     }
+    if (!__configFits(config)) {
+        // frame of keypad can't hold all keys
+        return 0;
+    }
+#if KEYPAD_MAX_NUM > 0
+    if (!keypad->Configured && __activesLen(context) >= KEYPAD_MAX_NUM) {
+        return 0;
+    }
+#endif // KEYPAD_MAX_NUM
+#if KEYPAD_SHARD
+    if (keypad->Configured && keypad->Context != context) {
+        // keypad is in list of other context
+        return 0;
+    }
+    keypad->Context = context;
+#endif // KEYPAD_SHARD
+#if KEYPAD_CONCURRENT
+    if (__load(keypad->Configured)) {
+        // keypad is in list or wait for release, KeyPad_handle maybe use it
+        return 0;
+    }
+#endif // KEYPAD_CONCURRENT
     // add new keypad to list
     keypad->State = KeyPad_State_None;
     keypad->NotActive = KeyPad_NotHandled;
+    keypad->Ghost = 0;
+#if KEYPAD_SHARED_CALLBACKS
+    if (keypad->Callbacks == 0) {
+        keypad->Callbacks = &keypadCallbacksNone;
+    }
+#endif // KEYPAD_SHARED_CALLBACKS
+#if KEYPAD_NKRO
+    KeyPad_resetFrame(keypad);
+#elif KEYPAD_DEBOUNCE
+    keypad->Debounce = 0;
+#endif // KEYPAD_NKRO
+#if KEYPAD_EVENT_QUEUE && !KEYPAD_NKRO
+    keypad->Handled = KeyPad_NotHandled;
+#endif
+    __setShard(keypad, &context->Shard);
+#if KEYPAD_CHORD
+    KeyPad_setChords(keypad, keypad->Chords);
+#endif // KEYPAD_CHORD
+#if KEYPAD_SCAN_BUDGET || KEYPAD_SCAN_PIPELINE
+    keypad->ScanIndex = 0;
+#endif // KEYPAD_SCAN_BUDGET || KEYPAD_SCAN_PIPELINE
+#if KEYPAD_SCAN_PIPELINE
+    keypad->SettleTicks = 0;
+#endif // KEYPAD_SCAN_PIPELINE
+#if KEYPAD_STATS
+    keypad->Stats = keypadStatsEmpty.Counters;
+#endif // KEYPAD_STATS
+#if KEYPAD_HOLD_REPEAT
+    keypad->HoldDelay = KEYPAD_HOLD_DELAY;
+    keypad->RepeatDelay = KEYPAD_REPEAT_DELAY;
+    __setOutIndex(keypad, 0);
+    __setInIndex(keypad, 0);
+    __resetHold(keypad);
+#endif // KEYPAD_HOLD_REPEAT
     KeyPad_setConfig(keypad, config);
+#if KEYPAD_SCAN_GROUP
+    if (!keypad->Configured) {
+        KeyPad_joinGroup(keypad);
+    }
+#endif // KEYPAD_SCAN_GROUP
     // init IOs
     KeyPad_initOut(keypad);
     KeyPad_initIn(keypad);
 #if KEYPAD_MAX_NUM == -1
     // add keypad to linked list
     keypad->Previous = lastKeyPad;
-    lastKeyPad = keypad;
+    keypad->Next = KEYPAD_NULL;
+#if KEYPAD_CONCURRENT
+    // keypad must be ready before KeyPad_handle see it, release store of list publish its fields
+    keypad->Enabled = 1;
+    __publish(keypad->Retired, 0);
+    __publish(keypad->Configured, 1);
+#endif // KEYPAD_CONCURRENT
+    if (KEYPAD_NULL != lastKeyPad) {
+        lastKeyPad->Next = keypad;
+    }
+    __publish(lastKeyPad, keypad);
+#else
+    // add keypad to end of active list, if it's in list only config changed
+    if (!keypad->Configured) {
+        keypad->Index = __activesLen(context);
+        __actives(context)[__activesLen(context)++] = keypad;
+    }
 #endif // KEYPAD_MAX_NUM == -1
+#if !KEYPAD_CONCURRENT
     keypad->Configured = 1;
     keypad->Enabled = 1;
+#endif // !KEYPAD_CONCURRENT
+#if KEYPAD_IDLE_WAKE
+    // new keypad must scan before go to idle
+    if (keypadIdle) {
+        keypadWake = 1;
+    }
+#endif // KEYPAD_IDLE_WAKE
     return 1;
 }
 /**
@@ -192,56 +921,166 @@ uint8_t KeyPad_add(KeyPad* keypad, const KeyPad_Config* config) {
  * 
  * @param remove address of keypad
  * @return uint8_t return 1 if keypad found, 0 if not found
+ * slot of KeyPad_new release only when it removed, a rejected remove keep its slot
+ * in concurrent mode also 0 if KEYPAD_RETIRE_SIZE keypads removed in running KeyPad_handle, remove it again after handle
  */
 uint8_t KeyPad_remove(KeyPad* remove) {
+#if KEYPAD_IDLE_WAKE && !KEYPAD_CONCURRENT
+    if (keypadIdle && remove->Configured) {
+        // release pins of keypad, other keypads stay in idle
+        KeyPad_setIdleKeyPad(remove, 0);
+    }
+#endif // KEYPAD_IDLE_WAKE
+    if (!__load(remove->Configured)) {
+        return 0;
+    }
+#if KEYPAD_CONCURRENT
+    if (__load(remove->Retired)) {
+        return 0;
+    }
+    if ((uint8_t) (retiredHead - __load(retiredTail)) >= KEYPAD_RETIRE_SIZE) {
+        // running KeyPad_handle can't release more keypads, only it empty ring so it stay full until handle end
+        return 0;
+    }
+#endif // KEYPAD_CONCURRENT
+#if KEYPAD_SCAN_GROUP
+    KeyPad_leaveGroup(remove);
+#endif // KEYPAD_SCAN_GROUP
+    // deinit IO
+#if KEYPAD_USE_DEINIT && !KEYPAD_CONCURRENT
+    KeyPad_deinitPins(remove);
+#endif
 #if KEYPAD_MAX_NUM == -1
-    KeyPad* pKeyPad = lastKeyPad;
-    // check last keypad first
-    if (remove == pKeyPad) {
-        // deinit IO
-    #if KEYPAD_USE_DEINIT
-        if (keypadDriver->deinitPin) {
-            keypadDriver->deinitPin(remove->Config);
-        }
-    #endif
-        // remove keypad dropped from link list
-        pKeyPad->Previous = remove->Previous;
-        remove->Previous = KEYPAD_NULL;
-        remove->Configured = 0;
-        remove->Enabled = 0;
-        return 1;
+#if KEYPAD_SCAN_BUDGET
+    if (scanKeyPad == remove) {
+        __scanNext();
+        scanAdvanced = 1;
+    }
+#endif // KEYPAD_SCAN_BUDGET
+    // remove keypad dropped from link list
+    // Previous of removed keypad is not changed, so KeyPad_handle can continue if keypad removed in callback
+    if (KEYPAD_NULL != remove->Next) {
+        __publish(remove->Next->Previous, remove->Previous);
+    }
+    else {
+        __publish(lastKeyPad, remove->Previous);
+    }
+    if (KEYPAD_NULL != remove->Previous) {
+        remove->Previous->Next = remove->Next;
+    }
+    remove->Next = KEYPAD_NULL;
+#else
+    // move last keypad into place of removed keypad
+    __actives(__context(remove))[remove->Index] = __actives(__context(remove))[--__activesLen(__context(remove))];
+    __actives(__context(remove))[remove->Index]->Index = remove->Index;
+#if KEYPAD_SCAN_BUDGET
+    if (scanIndex == remove->Index) {
+        // cursor point to keypad that moved into place of removed keypad and it is not scanned yet
+        scanAdvanced = 1;
+    }
+#endif // KEYPAD_SCAN_BUDGET
+    // release slot of array only after keypad left active list, so KeyPad_new can't return a keypad that still scanned
+    if (remove >= keypads && remove < keypads + KEYPAD_MAX_NUM) {
+        uint16_t index = (uint16_t) (remove - keypads);
+        keypadsUsed[index / 32] &= ~((uint32_t) 1 << (index & 31));
+    }
+#endif // KEYPAD_MAX_NUM == -1
+#if KEYPAD_CONCURRENT
+    // release pins when no KeyPad_handle point to keypad
+    KeyPad_retire(remove);
+#else
+    remove->Configured = 0;
+    remove->Enabled = 0;
+#endif // KEYPAD_CONCURRENT
+    return 1;
+}
+#if KEYPAD_CONCURRENT
+/**
+ * @brief release unlinked keypad now if KeyPad_handle is not running, otherwise running KeyPad_handle release it at end
+ */
+static void KeyPad_retire(KeyPad* keypad) {
+    __publish(keypad->Retired, 1);
+    // add zero only read seq, but a plain load maybe read old even seq while KeyPad_handle start
+    if ((KEYPAD_FETCH_ADD(keypadHandleSeq, 0) & 1) == 0) {
+        // next KeyPad_handle can't reach keypad
+        KeyPad_release(keypad);
+        return;
+    }
+    // KeyPad_remove checked ring has space
+    keypadsRetired[retiredHead & (KEYPAD_RETIRE_SIZE - 1)] = keypad;
+    __publish(retiredHead, (uint8_t) (retiredHead + 1));
+}
+/**
+ * @brief release keypads that removed while KeyPad_handle was running, call at end of KeyPad_handle
+ */
+static void KeyPad_reclaim(void) {
+    while (retiredTail != __load(retiredHead)) {
+        KeyPad_release(keypadsRetired[retiredTail & (KEYPAD_RETIRE_SIZE - 1)]);
+        __publish(retiredTail, (uint8_t) (retiredTail + 1));
+    }
+}
+/**
+ * @brief apply config of KeyPad_setConfig between scans of keypad, while no key of old config is pressed
+ * or debounced and no output is strobed, scan state belong to old config so it reset
+ */
+static void KeyPad_applyConfig(KeyPad* keypad) {
+    const KeyPad_Config* config = __load(keypad->NewConfig);
+    if (config == keypad->Config) {
+        return;
+    }
+#if KEYPAD_SCAN_PIPELINE
+    if (keypad->SettleTicks != 0) {
+        // an output of old config is strobed
+        return;
     }
-    while (KEYPAD_NULL != pKeyPad) {
-        if (remove == pKeyPad->Previous) {
-            // deinit IO
-		#if KEYPAD_USE_DEINIT
-            if (keypadDriver->deinitPin) {
-                keypadDriver->deinitPin(remove->Config);
+    keypad->ScanIndex = 0;
+#endif // KEYPAD_SCAN_PIPELINE
+#if KEYPAD_NKRO
+    {
+        KeyPad_LenType outIndex;
+        for (outIndex = 0; outIndex < __outNum(keypad); outIndex++) {
+            if (keypad->Frame[outIndex]) {
+                // keys of old config are pressed
+                return;
             }
-        #endif
-            // remove keypad dropped from link list
-            pKeyPad->Previous = remove->Previous;
-            remove->Previous = KEYPAD_NULL;
-            remove->Configured = 0;
-            remove->Enabled = 0;
-            return 1;
         }
-        pKeyPad = pKeyPad->Previous;
     }
+    KeyPad_resetFrame(keypad);
 #else
-    uint8_t len = KEYPAD_MAX_NUM;
-    KeyPad* pKeyPad = keypads;
-    while (len--) {
-        if (remove == pKeyPad && pKeyPad->Configured) {
-            pKeyPad->Configured = 0;
-            pKeyPad->Enabled = 0;
-            return 1;
-        }
-        pKeyPad++;
+    if (!__needScan(keypad)) {
+        // key of old config is pressed or debounced
+        return;
     }
-#endif // KEYPAD_MAX_NUM == -1
-    return 0;
+#endif // KEYPAD_NKRO
+#if KEYPAD_HOLD_REPEAT
+    __setOutIndex(keypad, 0);
+    __setInIndex(keypad, 0);
+    __resetHold(keypad);
+#endif // KEYPAD_HOLD_REPEAT
+#if KEYPAD_CHORD
+    KeyPad_setChords(keypad, keypad->Chords);
+#endif // KEYPAD_CHORD
+    __publish(keypad->Config, config);
+}
+/**
+ * @brief release pins of removed keypad, after it keypad can add again
+ */
+static void KeyPad_release(KeyPad* keypad) {
+#if KEYPAD_IDLE_WAKE
+    if (keypadIdle) {
+        // release pins of keypad, other keypads stay in idle
+        KeyPad_setIdleKeyPad(keypad, 0);
+    }
+#endif // KEYPAD_IDLE_WAKE
+#if KEYPAD_USE_DEINIT
+    KeyPad_deinitPins(keypad);
+#endif
+    keypad->Enabled = 0;
+    // pins and fields of keypad are free after this store, Retired stay set until KeyPad_add
+    // so KeyPad_remove that run between two stores can't unlink keypad again
+    __publish(keypad->Configured, 0);
 }
+#endif // KEYPAD_CONCURRENT
 /**
  * @brief finding keypad based on PinConfig in list
  * 
@@ -249,28 +1088,29 @@ uint8_t KeyPad_remove(KeyPad* remove) {
  * @return KeyPad* 
  */
 KeyPad* KeyPad_find(const KeyPad_Config* config) {
-#if KEYPAD_MAX_NUM == -1
-    KeyPad* pKeyPad = lastKeyPad;
-    while (KEYPAD_NULL != pKeyPad) {
-        if (config == pKeyPad->Config) {
-            return pKeyPad;
-        }
-        pKeyPad = pKeyPad->Previous;
-    }
-#else
-    uint8_t len = KEYPAD_MAX_NUM;
-    KeyPad* pKeyPad = keypads;
-    while (len--) {
+    KeyPad* pKeyPad;
+    __forEachKeyPad(pKeyPad) {
         if (config == pKeyPad->Config) {
             return pKeyPad;
         }
-        pKeyPad++;
     }
-#endif // KEYPAD_MAX_NUM == -1
     return KEYPAD_NULL;
 }
 
-#if KEYPAD_MULTI_CALLBACK
+#if KEYPAD_SHARED_CALLBACKS
+/**
+ * @brief set callback table of keypad, table must be alive while keypad use it
+ * 
+ * @param keypad 
+ * @param callbacks shared callback table, null remove callbacks
+ */
+void KeyPad_setCallbacks(KeyPad* keypad, const KeyPad_Callbacks* callbacks) {
+    keypad->Callbacks = callbacks ? callbacks : &keypadCallbacksNone;
+}
+const KeyPad_Callbacks* KeyPad_getCallbacks(KeyPad* keypad) {
+    return keypad->Callbacks;
+}
+#elif KEYPAD_MULTI_CALLBACK
 void KeyPad_onHold(KeyPad* keypad, KeyPad_Callback cb) {
     keypad->Callbacks.onHold = cb;
 }
@@ -285,14 +1125,31 @@ void KeyPad_onNone(KeyPad* keypad, KeyPad_Callback cb) {
     keypad->Callbacks.onNone = cb;
 }
 #endif // KEYPAD_NONE_CALLBACK
+#if KEYPAD_HOLD_REPEAT
+void KeyPad_onLongPress(KeyPad* keypad, KeyPad_Callback cb) {
+    keypad->Callbacks.onLongPress = cb;
+}
+void KeyPad_onRepeat(KeyPad* keypad, KeyPad_Callback cb) {
+    keypad->Callbacks.onRepeat = cb;
+}
+#endif // KEYPAD_HOLD_REPEAT
 #else
 void KeyPad_onChange(KeyPad* keypad, KeyPad_Callback cb) {
     keypad->Callbacks.onChange = cb;
 }
-#endif // KEYPAD_MULTI_CALLBACK
+#endif // KEYPAD_SHARED_CALLBACKS
 
 #if KEYPAD_ACTIVE_STATE
 void KeyPad_setActiveState(KeyPad* keypad, KeyPad_ActiveState state) {
+#if KEYPAD_SCAN_GROUP
+    if (keypad->Configured) {
+        // keypads with different active state can't share outputs
+        KeyPad_leaveGroup(keypad);
+        keypad->ActiveState = (uint8_t) state;
+        KeyPad_joinGroup(keypad);
+        return;
+    }
+#endif // KEYPAD_SCAN_GROUP
     keypad->ActiveState = (uint8_t) state;
 }
 KeyPad_ActiveState KeyPad_getActiveState(KeyPad* keypad) {
@@ -300,15 +1157,197 @@ KeyPad_ActiveState KeyPad_getActiveState(KeyPad* keypad) {
 }
 #endif /* KEYPAD_ACTIVE_STATE_ENABLE */
 
-#if KEYPAD_ENABLE_FLAG
-void KeyPad_setEnabled(KeyPad* keypad, uint8_t enabled) {
-    keypad->Enabled = enabled;
+#if KEYPAD_HOLD_REPEAT
+/**
+ * @brief set number of ticks that key must hold before long press event
+ * KeyPad_add reset it to KEYPAD_HOLD_DELAY
+ * 
+ * @param keypad 
+ * @param ticks 0 disable long press and repeat events
+ */
+void KeyPad_setHoldDelay(KeyPad* keypad, uint16_t ticks) {
+    keypad->HoldDelay = ticks;
 }
-uint8_t KeyPad_isEnabled(KeyPad* keypad) {
-    return keypad->Enabled;
+uint16_t KeyPad_getHoldDelay(KeyPad* keypad) {
+    return keypad->HoldDelay;
 }
-#endif
-
+/**
+ * @brief set number of ticks between repeat events after long press
+ * KeyPad_add reset it to KEYPAD_REPEAT_DELAY
+ * 
+ * @param keypad 
+ * @param ticks 0 disable repeat events
+ */
+void KeyPad_setRepeatDelay(KeyPad* keypad, uint16_t ticks) {
+    keypad->RepeatDelay = ticks;
+}
+uint16_t KeyPad_getRepeatDelay(KeyPad* keypad) {
+    return keypad->RepeatDelay;
+}
+#endif // KEYPAD_HOLD_REPEAT
+
+#if KEYPAD_NKRO
+/**
+ * @brief check key is hold in last frame or not
+ * 
+ * @param keypad 
+ * @param outIndex index of output pin
+ * @param inIndex index of input pin
+ * @return uint8_t 1 if key is pressed
+ */
+uint8_t KeyPad_isPressed(KeyPad* keypad, KeyPad_LenType outIndex, KeyPad_LenType inIndex) {
+    return (keypad->Frame[outIndex] >> inIndex) & 1;
+}
+#if KEYPAD_NKRO_GHOST
+/**
+ * @brief show last frame is ambiguous and new pressed keys ignored
+ * 
+ * @param keypad 
+ * @return uint8_t 
+ */
+uint8_t KeyPad_hasGhost(KeyPad* keypad) {
+    return keypad->Ghost;
+}
+#endif // KEYPAD_NKRO_GHOST
+#if KEYPAD_CHORD
+/**
+ * @brief build index of chord table, chords of each key and keys of all chords
+ * so each key change only AND chords of key with candidate chords
+ * 
+ * @param chords index that fill, it must be alive while keypads use it
+ * @param table chord table, first chord win when some chords matched
+ * @param len number of chords, at most KEYPAD_CHORD_MAX
+ * @return uint8_t 0 if len is too big or a chord has no key
+ */
+uint8_t KeyPad_initChords(KeyPad_Chords* chords, const KeyPad_Chord* table, uint8_t len) {
+    uint8_t index;
+    uint8_t key;
+    if (len > KEYPAD_CHORD_MAX) {
+        return 0;
+    }
+    chords->Table = table;
+    chords->Len = len;
+    chords->Keys = 0;
+    for (key = 0; key < KEYPAD_CHORD_KEYS; key++) {
+        chords->KeyRules[key] = 0;
+    }
+    for (index = 0; index < len; index++) {
+        KeyPad_ChordMask keys = table[index].Keys;
+        if (keys == 0) {
+            return 0;
+        }
+        chords->Keys |= keys;
+        while (keys) {
+            chords->KeyRules[KEYPAD_CTZ(keys)] |= (KeyPad_ChordRules) 1 << index;
+            keys &= keys - 1;
+        }
+    }
+    return 1;
+}
+/**
+ * @brief set chords of keypad, call it while no key of keypad pressed
+ * 
+ * @param keypad 
+ * @param chords chords that filled with KeyPad_initChords, null disable chords
+ */
+void KeyPad_setChords(KeyPad* keypad, const KeyPad_Chords* chords) {
+    keypad->Chords = chords;
+    keypad->ChordDown = 0;
+    keypad->ChordPending = 0;
+    keypad->ChordUsed = 0;
+    keypad->ChordRules = (KeyPad_ChordRules) ~0;
+    keypad->ChordTicks = 0;
+    keypad->ChordIndex = KEYPAD_CHORD_NONE;
+}
+/**
+ * @brief set chord callback, it fire with value of chord and KeyPad_State_Pressed when chord matched
+ * and KeyPad_State_Released when first key of chord released, return value is ignored
+ * 
+ * @param keypad 
+ * @param cb 
+ */
+void KeyPad_onChord(KeyPad* keypad, KeyPad_Callback cb) {
+    keypad->ChordCallback = cb;
+}
+#endif // KEYPAD_CHORD
+#if KEYPAD_FRAME_CAPTURE
+/**
+ * @brief process a frame that captured by hardware, same as scan of keypad in KeyPad_handle
+ * user call it instead of KeyPad_handle for each captured frame, each call is one tick
+ * 
+ * @param keypad 
+ * @param inputs levels of inputs in strobe of each output, same as value of readPort
+ * inputs[N] captured in N-th strobe and bit M of it is level of M-th input
+ * @param len number of captured strobes, must be number of outputs of keypad
+ * @return uint8_t 1 if frame processed, 0 if keypad not added, len is not number of outputs or it's bigger than KEYPAD_NKRO_MAX_OUT
+ */
+uint8_t KeyPad_processFrame(KeyPad* keypad, const KeyPad_PortMask* inputs, KeyPad_LenType len) {
+    KeyPad_PortMask frame[KEYPAD_NKRO_MAX_OUT];
+    KeyPad_PortMask mask;
+    KeyPad_LenType outIndex;
+    uint8_t state = __activeState(keypad);
+#if KEYPAD_SHARD && KEYPAD_EVENT_QUEUE
+    __context(keypad)->Shard.Tick++;
+#elif KEYPAD_EVENT_QUEUE || KEYPAD_ADAPTIVE_RATE
+    keypadTick++;
+#endif // KEYPAD_SHARD && KEYPAD_EVENT_QUEUE
+#if KEYPAD_ADAPTIVE_RATE
+    keypadElapsed = 1;
+#endif // KEYPAD_ADAPTIVE_RATE
+    __handleBegin();
+#if KEYPAD_CONCURRENT
+    KeyPad_applyConfig(keypad);
+#endif // KEYPAD_CONCURRENT
+    if (!__load(keypad->Configured) || len != __outNum(keypad) || len > KEYPAD_NKRO_MAX_OUT) {
+        // keypad not added, frame captured with another config or it's bigger than frame of keypad
+        __handleEnd();
+        return 0;
+    }
+    if (__isEnabled(keypad)) {
+        __count(keypad, Scans);
+        mask = __portMask(__inNum(keypad));
+        for (outIndex = 0; outIndex < len; outIndex++) {
+            frame[outIndex] = (state ? inputs[outIndex] : ~inputs[outIndex]) & mask;
+        }
+        KeyPad_applyFrame(keypad, frame);
+    }
+    __handleEnd();
+    return 1;
+}
+/**
+ * @brief make values of outputs for strobes of a scan, hardware write pattern[N] on outputs
+ * and capture inputs in N-th strobe, bit M of a value is level of M-th output, same as value of writePort
+ * 
+ * @param config config of keypad
+ * @param state active state of keypad
+ * @param pattern values of strobes, one for each output
+ * @return KeyPad_LenType number of values, 0 if config is out of limits of nkro frame, same as KeyPad_add
+ */
+KeyPad_LenType KeyPad_strobePattern(const KeyPad_Config* config, KeyPad_ActiveState state, KeyPad_PortMask* pattern) {
+    KeyPad_LenType len = __configOutNum(config);
+    KeyPad_PortMask mask = __portMask(len);
+    KeyPad_LenType outIndex;
+    if (!__configFits(config) || len > (KeyPad_LenType) (sizeof(KeyPad_PortMask) * 8)) {
+        return 0;
+    }
+    for (outIndex = 0; outIndex < len; outIndex++) {
+        KeyPad_PortMask bit = (KeyPad_PortMask) 1 << outIndex;
+        pattern[outIndex] = state ? bit : (~bit & mask);
+    }
+    return len;
+}
+#endif // KEYPAD_FRAME_CAPTURE
+#endif // KEYPAD_NKRO
+
+#if KEYPAD_ENABLE_FLAG
+void KeyPad_setEnabled(KeyPad* keypad, uint8_t enabled) {
+    keypad->Enabled = enabled;
+}
+uint8_t KeyPad_isEnabled(KeyPad* keypad) {
+    return keypad->Enabled;
+}
+#endif
+
 #if KEYPAD_ARGS
 void KeyPad_setArgs(KeyPad*, void* args) {
     keypad->Args = args;
@@ -325,11 +1364,29 @@ void* KeyPad_getArgs(KeyPad* keypad) {
 static void KeyPad_initOut(KeyPad* keypad) {
     KeyPad_PinMode mode = __outPinMode(keypad);
     const KeyPad_PinConfig* config = &__outPin(keypad, 0);
-    uint8_t len = __outNum(keypad);
+    KeyPad_LenType len = __outNum(keypad);
     uint8_t state = !__activeState(keypad);
+    if (__isAnalog(keypad)) {
+        // levels of ladder have no pin
+        return;
+    }
+#if KEYPAD_OUT_SHADOW
+    // level of outputs is unknown before init, so write all of them
+    keypad->OutShadow = state ? __portMask(len) : 0;
+#endif // KEYPAD_OUT_SHADOW
+#if KEYPAD_USE_PORT
+    if (__useWritePort(keypad)) {
+        // write all outputs in one call
+        __driver(keypad)->writePort(config, len, state ? __portMask(len) : 0);
+        while (len-- > 0) {
+            __driver(keypad)->initPin(config++, mode);
+        }
+        return;
+    }
+#endif // KEYPAD_USE_PORT
     while (len-- > 0) {
-        keypadDriver->writePin(config, state);
-        keypadDriver->initPin(config++, mode);
+        __driver(keypad)->writePin(config, state);
+        __driver(keypad)->initPin(config++, mode);
     }
 }
 /**
@@ -338,35 +1395,1193 @@ static void KeyPad_initOut(KeyPad* keypad) {
  * @param keypad 
  */
 static void KeyPad_initIn(KeyPad* keypad) {
-    KeyPad_PinMode mode = __inPinMode(keypad);
+    KeyPad_PinMode mode = __isAnalog(keypad) ? KeyPad_PinMode_Analog : __inPinMode(keypad);
     const KeyPad_PinConfig* config = &__inPin(keypad, 0);
-    uint8_t len = __inNum(keypad);
+    KeyPad_LenType len = __inNum(keypad);
     while (len-- > 0) {
-        keypadDriver->initPin(config++, mode);
+        __driver(keypad)->initPin(config++, mode);
     }
 }
+#if KEYPAD_SCAN_BUDGET
+/**
+ * @brief do one step of keypad scan, scan an output or check pressed key
+ * 
+ * @return uint8_t 1 if scan of keypad is done, 0 if it continue in next step
+ */
+static uint8_t KeyPad_scanStep(KeyPad* keypad) {
+    uint8_t state = __activeState(keypad);
+#if KEYPAD_NKRO
+    keypad->Scan[keypad->ScanIndex] = KeyPad_readOut(keypad, keypad->ScanIndex, state);
+    if (++keypad->ScanIndex < __outNum(keypad)) {
+        return 0;
+    }
+    keypad->ScanIndex = 0;
+    KeyPad_endFrame(keypad, keypad->Scan, state);
+    return 1;
+#else
+    if (!__needScan(keypad)) {
+        // scan only pressed key
+        KeyPad_checkKey(keypad);
+        return 1;
+    }
+#if KEYPAD_ANALOG
+    if (__isAnalog(keypad)) {
+        KeyPad_scanLevels(keypad);
+        return 1;
+    }
+#endif // KEYPAD_ANALOG
+    if (KeyPad_scanOut(keypad, keypad->ScanIndex, state)) {
+        keypad->ScanIndex = 0;
+        return 1;
+    }
+    if (++keypad->ScanIndex < __outNum(keypad)) {
+        return 0;
+    }
+    keypad->ScanIndex = 0;
+    KeyPad_endStrobe(keypad, state);
+    // fire callback if state is none
+    __fireNoneCallback(keypad);
+    return 1;
+#endif // KEYPAD_NKRO
+}
+#endif // KEYPAD_SCAN_BUDGET
+#if KEYPAD_SCAN_PIPELINE
+/**
+ * @brief strobe an output in a handle and read it after Settle handles of config
+ * next output strobe right after read, so each output settle while handle is out or scan other keypads
+ */
+static void KeyPad_pipeStep(KeyPad* keypad) {
+    uint8_t state = __activeState(keypad);
+#if !KEYPAD_NKRO
+    if (!__needScan(keypad)) {
+        // output of pressed key is active yet
+        KeyPad_checkKey(keypad);
+        return;
+    }
+#if KEYPAD_ANALOG
+    if (__isAnalog(keypad)) {
+        // conversion has no settle time of outputs
+        KeyPad_scanLevels(keypad);
+        return;
+    }
+#endif // KEYPAD_ANALOG
+#endif // !KEYPAD_NKRO
+    if (keypad->SettleTicks == 0) {
+        // start new scan
+        KeyPad_pipeStrobe(keypad, state);
+        return;
+    }
+    if (--keypad->SettleTicks > 0) {
+        return;
+    }
+#if KEYPAD_NKRO
+    keypad->Scan[keypad->ScanIndex] = KeyPad_readIn(keypad, state);
+    KeyPad_releaseOut(keypad, keypad->ScanIndex, state);
+    if (++keypad->ScanIndex < __outNum(keypad)) {
+        KeyPad_pipeStrobe(keypad, state);
+        return;
+    }
+    keypad->ScanIndex = 0;
+    KeyPad_endFrame(keypad, keypad->Scan, state);
+#else
+    if (KeyPad_sampleOut(keypad, keypad->ScanIndex, state)) {
+        keypad->ScanIndex = 0;
+        return;
+    }
+    if (++keypad->ScanIndex < __outNum(keypad)) {
+        KeyPad_pipeStrobe(keypad, state);
+        return;
+    }
+    keypad->ScanIndex = 0;
+    KeyPad_endStrobe(keypad, state);
+    // fire callback if state is none
+    __fireNoneCallback(keypad);
+#endif // KEYPAD_NKRO
+}
+/**
+ * @brief strobe output of ScanIndex and start settle time
+ */
+static void KeyPad_pipeStrobe(KeyPad* keypad, uint8_t state) {
+    KeyPad_strobeOut(keypad, keypad->ScanIndex, state);
+    keypad->SettleTicks = keypad->Config->Settle;
+}
+#endif // KEYPAD_SCAN_PIPELINE
+#if KEYPAD_USE_DEINIT
+/**
+ * @brief deinit output and input pins
+ * 
+ * @param keypad 
+ */
+static void KeyPad_deinitPins(KeyPad* keypad) {
+    const KeyPad_PinConfig* config;
+    KeyPad_LenType len;
+    if (!__driver(keypad)->deinitPin) {
+        return;
+    }
+    config = &__outPin(keypad, 0);
+    len = __isAnalog(keypad) ? 0 : __outNum(keypad);
+    while (len-- > 0) {
+        __driver(keypad)->deinitPin(config++);
+    }
+    config = &__inPin(keypad, 0);
+    len = __inNum(keypad);
+    while (len-- > 0) {
+        __driver(keypad)->deinitPin(config++);
+    }
+}
+#endif // KEYPAD_USE_DEINIT
+#if !KEYPAD_NKRO
+#if !KEYPAD_SCAN_BUDGET
 /**
  * @brief scan all keys for found a pressed key
  */
 static void KeyPad_scanKeys(KeyPad* keypad) {
     KeyPad_LenType outIndex;
+    uint8_t state = __activeState(keypad);
+#if KEYPAD_ANALOG
+    if (__isAnalog(keypad)) {
+        KeyPad_scanLevels(keypad);
+        return;
+    }
+#endif // KEYPAD_ANALOG
+    for (outIndex = 0; outIndex < __outNum(keypad); outIndex++) {
+        if (KeyPad_scanOut(keypad, outIndex, state)) {
+            return;
+        }
+    }
+    KeyPad_endStrobe(keypad, state);
+    // fire callback if state is none
+    __fireNoneCallback(keypad);
+}
+#endif // !KEYPAD_SCAN_BUDGET
+/**
+ * @brief scan inputs of an output for found a pressed key
+ * 
+ * @return uint8_t 1 if key found
+ */
+static uint8_t KeyPad_scanOut(KeyPad* keypad, KeyPad_LenType outIndex, uint8_t state) {
+    KeyPad_strobeOut(keypad, outIndex, state);
+    return KeyPad_sampleOut(keypad, outIndex, state);
+}
+/**
+ * @brief read inputs of strobed output for found a pressed key, release output if not found
+ * 
+ * @return uint8_t 1 if key found
+ */
+static uint8_t KeyPad_sampleOut(KeyPad* keypad, KeyPad_LenType outIndex, uint8_t state) {
+    KeyPad_LenType inIndex = KeyPad_findIn(keypad, state);
+    if (inIndex != __INDEX_NONE) {
+        KeyPad_pressKey(keypad, outIndex, inIndex);
+        return 1;
+    }
+    KeyPad_releaseOut(keypad, outIndex, state);
+    return 0;
+}
+/**
+ * @brief keep found key and fire pressed, or wait for debounce of it
+ */
+static void KeyPad_pressKey(KeyPad* keypad, KeyPad_LenType outIndex, KeyPad_LenType inIndex) {
+    __setOutIndex(keypad, outIndex);
+    __setInIndex(keypad, inIndex);
+    __resetHold(keypad);
+#if KEYPAD_DEBOUNCE
+    // wait for key become stable, checkKey fire pressed
+    keypad->Debounce = 1;
+#else
+    // key pressed
+    keypad->State = KeyPad_State_Pressed;
+    __pressLatency();
+    __fireCallback(keypad, __value(keypad, outIndex, inIndex));
+#endif // KEYPAD_DEBOUNCE
+}
+/**
+ * @brief check pressed key and fire hold or released
+ */
+static void KeyPad_checkKey(KeyPad* keypad) {
+    KeyPad_LenType outIndex = __getOutIndex(keypad);
+    KeyPad_LenType inIndex = __getInIndex(keypad);
+    uint8_t state = __activeState(keypad);
+#if KEYPAD_ANALOG
+    uint8_t active = __isAnalog(keypad) ? KeyPad_inLevel(keypad, outIndex, __readAnalog(keypad, &__inPin(keypad, inIndex))) :
+                                          __readPin(keypad, &__inPin(keypad, inIndex)) == state;
+#else
+    uint8_t active = __readPin(keypad, &__inPin(keypad, inIndex)) == state;
+#endif // KEYPAD_ANALOG
+#if KEYPAD_DEBOUNCE
+    if (keypad->State == KeyPad_State_None) {
+        // key is not stable yet
+        if (!active) {
+            keypad->Debounce = 0;
+            if (!__isAnalog(keypad)) {
+                KeyPad_writeOut(keypad, outIndex, !state);
+            }
+        }
+        else if (++keypad->Debounce >= __DEBOUNCE_COUNT) {
+            // key pressed
+            keypad->Debounce = 0;
+            keypad->State = KeyPad_State_Pressed;
+            __pressLatency();
+            __fireCallback(keypad, __value(keypad, outIndex, inIndex));
+        }
+        return;
+    }
+    if (active) {
+        keypad->Debounce = 0;
+    }
+    else if (++keypad->Debounce < __DEBOUNCE_COUNT) {
+        // ignore release until it's stable
+        active = 1;
+    }
+    else {
+        keypad->Debounce = 0;
+    }
+#endif // KEYPAD_DEBOUNCE
+    // check pressed key
+    keypad->State = active ? KeyPad_State_Hold : KeyPad_State_Released;
+
+#if KEYPAD_HOLD_REPEAT
+    if (active) {
+        KeyPad_State event = KeyPad_holdEvent(keypad);
+        if (event == KeyPad_State_None) {
+            // nothing happen
+        }
+        else if (!keypad->NotActive) {
+            __fireEvent(keypad, __value(keypad, outIndex, inIndex), event);
+        }
+        else {
+            __count(keypad, Suppressed);
+        }
+    }
+    else
+#endif // KEYPAD_HOLD_REPEAT
+    if (!keypad->NotActive) {
+        __fireCallback(keypad, __value(keypad, outIndex, inIndex));
+    }
+    else {
+        __count(keypad, Suppressed);
+    }
+
+    if (keypad->State == KeyPad_State_Released) {
+        keypad->State = KeyPad_State_None;
+        if (!__isAnalog(keypad)) {
+            KeyPad_writeOut(keypad, outIndex, !state);
+        }
+    }
+}
+#if KEYPAD_ANALOG
+/**
+ * @brief convert inputs of analog keypad and keep first input that is in a level
+ */
+static void KeyPad_scanLevels(KeyPad* keypad) {
+    KeyPad_LenType inIndex;
+    KeyPad_LenType outIndex;
+    for (inIndex = 0; inIndex < __inNum(keypad); inIndex++) {
+        outIndex = KeyPad_findLevel(keypad, __readAnalog(keypad, &__inPin(keypad, inIndex)));
+        if (outIndex != __INDEX_NONE) {
+            KeyPad_pressKey(keypad, outIndex, inIndex);
+            return;
+        }
+    }
+    // fire callback if state is none
+    __fireNoneCallback(keypad);
+}
+/**
+ * @brief binary search of thresholds for level of value
+ * 
+ * @return KeyPad_LenType level, -1 if value is above last threshold or near bounds of its level
+ */
+static KeyPad_LenType KeyPad_findLevel(KeyPad* keypad, KeyPad_AnalogValue value) {
+    const KeyPad_AnalogValue* thresholds = keypad->Config->Thresholds;
+    KeyPad_AnalogValue hysteresis = keypad->Config->Hysteresis;
+    KeyPad_LenType low = 0;
+    KeyPad_LenType high = __outNum(keypad);
+    KeyPad_LenType mid;
+    // find first threshold that is above value
+    while (low < high) {
+        mid = (KeyPad_LenType) ((low + high) >> 1);
+        if (value < thresholds[mid]) {
+            high = mid;
+        }
+        else {
+            low = mid + 1;
+        }
+    }
+    if (low == __outNum(keypad) ||
+        (uint32_t) value + hysteresis >= thresholds[low] ||
+        (low > 0 && value < (uint32_t) thresholds[low - 1] + hysteresis)) {
+        return __INDEX_NONE;
+    }
+    return low;
+}
+/**
+ * @brief check value is in level of pressed key, bounds of level widen by hysteresis
+ */
+static uint8_t KeyPad_inLevel(KeyPad* keypad, KeyPad_LenType level, KeyPad_AnalogValue value) {
+    const KeyPad_AnalogValue* thresholds = keypad->Config->Thresholds;
+    KeyPad_AnalogValue hysteresis = keypad->Config->Hysteresis;
+    return value < (uint32_t) thresholds[level] + hysteresis &&
+           (level == 0 || (uint32_t) value + hysteresis >= thresholds[level - 1]);
+}
+#endif // KEYPAD_ANALOG
+#endif // !KEYPAD_NKRO
+/**
+ * @brief write level of an output, skip it if output is already in that level
+ */
+static void KeyPad_writeOut(KeyPad* keypad, KeyPad_LenType outIndex, uint8_t value) {
+#if KEYPAD_OUT_SHADOW
+    if (outIndex < (KeyPad_LenType) (sizeof(KeyPad_PortMask) * 8)) {
+        KeyPad_PortMask bit = (KeyPad_PortMask) 1 << outIndex;
+        if (((keypad->OutShadow & bit) != 0) == (value != 0)) {
+            return;
+        }
+        keypad->OutShadow ^= bit;
+    }
+#endif // KEYPAD_OUT_SHADOW
+    __writePin(keypad, &__outPin(keypad, outIndex), value);
+}
+#if KEYPAD_USE_PORT
+/**
+ * @brief write level of all outputs in one call, skip it if outputs are already in that levels
+ * 
+ * @param value bit N is level of N-th output
+ */
+static void KeyPad_writeOuts(KeyPad* keypad, KeyPad_PortMask value) {
+    KeyPad_LenType len = __outNum(keypad);
+#if KEYPAD_OUT_SHADOW
+    if (len <= (KeyPad_LenType) (sizeof(KeyPad_PortMask) * 8)) {
+        if (keypad->OutShadow == value) {
+            return;
+        }
+        keypad->OutShadow = value;
+    }
+#endif // KEYPAD_OUT_SHADOW
+    __writePort(keypad, &__outPin(keypad, 0), len, value);
+}
+#endif // KEYPAD_USE_PORT
+/**
+ * @brief drive output pin into active state
+ * with writePort all of other outputs drive into inactive state in same call
+ */
+static void KeyPad_strobeOut(KeyPad* keypad, KeyPad_LenType outIndex, uint8_t state) {
+#if KEYPAD_USE_PORT
+    if (__useWritePort(keypad)) {
+        KeyPad_LenType len = __outNum(keypad);
+        KeyPad_PortMask value = state ? 0 : __portMask(len);
+        KeyPad_writeOuts(keypad, value ^ ((KeyPad_PortMask) 1 << outIndex));
+        return;
+    }
+#endif // KEYPAD_USE_PORT
+    KeyPad_writeOut(keypad, outIndex, state);
+}
+/**
+ * @brief drive output pin into inactive state after read inputs
+ */
+static void KeyPad_releaseOut(KeyPad* keypad, KeyPad_LenType outIndex, uint8_t state) {
+#if KEYPAD_USE_PORT
+    // next strobe release current output
+    if (__useWritePort(keypad)) {
+        return;
+    }
+#endif // KEYPAD_USE_PORT
+    KeyPad_writeOut(keypad, outIndex, !state);
+}
+/**
+ * @brief drive all outputs into inactive state at the end of scan
+ */
+static void KeyPad_endStrobe(KeyPad* keypad, uint8_t state) {
+#if KEYPAD_USE_PORT
+    if (__useWritePort(keypad)) {
+        KeyPad_LenType len = __outNum(keypad);
+        KeyPad_writeOuts(keypad, state ? 0 : __portMask(len));
+    }
+#else
+    // each output released after its strobe
+    (void) keypad;
+    (void) state;
+#endif // KEYPAD_USE_PORT
+}
+#if KEYPAD_DEBOUNCE && (KEYPAD_IDLE_WAKE || KEYPAD_ADAPTIVE_RATE)
+/**
+ * @brief check any key of keypad wait for debounce
+ */
+static uint8_t KeyPad_isDebouncing(KeyPad* keypad) {
+#if KEYPAD_NKRO
+    KeyPad_LenType outIndex;
+    uint8_t bit;
+    for (outIndex = 0; outIndex < __outNum(keypad); outIndex++) {
+        for (bit = 0; bit < KEYPAD_DEBOUNCE_BITS; bit++) {
+            if (keypad->Debounce[bit][outIndex]) {
+                return 1;
+            }
+        }
+    }
+    return 0;
+#else
+    return keypad->Debounce != 0;
+#endif // KEYPAD_NKRO
+}
+#endif // KEYPAD_DEBOUNCE && (KEYPAD_IDLE_WAKE || KEYPAD_ADAPTIVE_RATE)
+#if KEYPAD_IDLE_WAKE || KEYPAD_ADAPTIVE_RATE
+/**
+ * @brief check keypad has no pressed key and no key wait for debounce
+ */
+static uint8_t KeyPad_isStable(KeyPad* keypad) {
+#if KEYPAD_SCAN_PIPELINE
+    if (keypad->SettleTicks != 0) {
+        // wait for read strobed output
+        return 0;
+    }
+#endif // KEYPAD_SCAN_PIPELINE
+#if KEYPAD_DEBOUNCE
+    if (KeyPad_isDebouncing(keypad)) {
+        return 0;
+    }
+#endif // KEYPAD_DEBOUNCE
+    return keypad->State == KeyPad_State_None;
+}
+#endif // KEYPAD_IDLE_WAKE || KEYPAD_ADAPTIVE_RATE
+#if KEYPAD_ADAPTIVE_RATE
+/**
+ * @brief find minimum period that keypads need
+ * 
+ * @return KeyPad_Tick ticks until next handle
+ */
+static KeyPad_Tick KeyPad_nextPeriod(void) {
+    KeyPad* pKeyPad;
+    KeyPad_Tick period = KEYPAD_IDLE_PERIOD;
+#if KEYPAD_IDLE_WAKE
+    if (keypadIdle) {
+        // wait for KeyPad_wake
+        return period;
+    }
+#endif // KEYPAD_IDLE_WAKE
+#if KEYPAD_SCAN_BUDGET
+    if (!__scanEnd()) {
+        // scan round is not complete
+        return KEYPAD_ACTIVE_PERIOD;
+    }
+#endif // KEYPAD_SCAN_BUDGET
+    __forEachKeyPad(pKeyPad) {
+    #if KEYPAD_ENABLE_FLAG
+        if (pKeyPad->Enabled) {
+    #endif // KEYPAD_ENABLE_FLAG
+        KeyPad_Tick keypadPeriod = KeyPad_period(pKeyPad);
+        if (keypadPeriod < period) {
+            period = keypadPeriod;
+        }
+    #if KEYPAD_ENABLE_FLAG
+        }
+    #endif // KEYPAD_ENABLE_FLAG
+    }
+    return period;
+}
+/**
+ * @brief return period that keypad need based on its state
+ * 
+ * @return KeyPad_Tick ticks until next handle
+ */
+static KeyPad_Tick KeyPad_period(KeyPad* keypad) {
+    KeyPad_Tick period;
+    if (KeyPad_isStable(keypad)) {
+        return KEYPAD_IDLE_PERIOD;
+    }
+#if KEYPAD_DEBOUNCE
+    if (KeyPad_isDebouncing(keypad)) {
+        return KEYPAD_ACTIVE_PERIOD;
+    }
+#endif // KEYPAD_DEBOUNCE
+    if (keypad->State != KeyPad_State_Hold) {
+        // key pressed or released now
+        return KEYPAD_ACTIVE_PERIOD;
+    }
+    period = KEYPAD_HOLD_PERIOD;
+#if KEYPAD_HOLD_REPEAT
+    {
+        uint16_t delay = keypad->LongPressed ? keypad->RepeatDelay : keypad->HoldDelay;
+        if (keypad->HoldDelay != 0 && delay != 0 && (KeyPad_Tick) (delay - keypad->HoldTicks) < period) {
+            // wake up for next long press or repeat
+            period = delay - keypad->HoldTicks;
+        }
+    }
+#endif // KEYPAD_HOLD_REPEAT
+    return period;
+}
+#endif // KEYPAD_ADAPTIVE_RATE
+#if KEYPAD_IDLE_WAKE
+/**
+ * @brief enter or leave idle mode
+ */
+static void KeyPad_setIdle(uint8_t enable) {
+    if (enable) {
+        keypadWake = 0;
+        KEYPAD_MEMORY_BARRIER();
+        if (KeyPad_setIdleAll(1)) {
+            // a key pressed before wake enabled
+            KeyPad_setIdleAll(0);
+            return;
+        }
+        keypadIdle = 1;
+    }
+    else {
+        KeyPad_setIdleAll(0);
+        keypadIdle = 0;
+    }
+}
+/**
+ * @brief enter or leave idle mode for all keypads
+ * 
+ * @return uint8_t 1 if any input is active after enable idle
+ */
+static uint8_t KeyPad_setIdleAll(uint8_t enable) {
+    KeyPad* pKeyPad;
+    uint8_t active = 0;
+    __forEachKeyPad(pKeyPad) {
+    #if KEYPAD_ENABLE_FLAG
+        // disabled keypads not scanned, but must release them on leave
+        if (pKeyPad->Enabled || !enable) {
+    #endif // KEYPAD_ENABLE_FLAG
+        active |= KeyPad_setIdleKeyPad(pKeyPad, enable);
+    #if KEYPAD_ENABLE_FLAG
+        }
+    #endif // KEYPAD_ENABLE_FLAG
+    }
+    return active;
+}
+/**
+ * @brief drive all outputs of keypad active and enable wake of inputs, or reverse it
+ * 
+ * @return uint8_t 1 if any input is active after enable idle
+ */
+static uint8_t KeyPad_setIdleKeyPad(KeyPad* keypad, uint8_t enable) {
+    const KeyPad_PinConfig* config;
+    KeyPad_LenType len = __outNum(keypad);
+    uint8_t state = __activeState(keypad);
+    uint8_t value = enable ? state : !state;
+    uint8_t active = 0;
+    if (__isAnalog(keypad)) {
+        // adc inputs have no edge, so analog keypad keep others out of idle
+        return enable;
+    }
+    // drive all outputs, so any pressed key change its input
+#if KEYPAD_USE_PORT
+    if (__useWritePort(keypad)) {
+        KeyPad_writeOuts(keypad, value ? __portMask(len) : 0);
+    }
+    else
+#endif // KEYPAD_USE_PORT
+    while (len-- > 0) {
+        KeyPad_writeOut(keypad, len, value);
+    }
+    config = &__inPin(keypad, 0);
+    len = __inNum(keypad);
+    while (len-- > 0) {
+        __driver(keypad)->setWakePin(config, enable);
+        if (enable && __readPin(keypad, config) == state) {
+            active = 1;
+        }
+        config++;
+    }
+    return active;
+}
+#endif // KEYPAD_IDLE_WAKE
+#if !KEYPAD_NKRO
+/**
+ * @brief find first input pin that is in active state
+ * 
+ * @return KeyPad_LenType index of input, -1 if not found
+ */
+static KeyPad_LenType KeyPad_findIn(KeyPad* keypad, uint8_t state) {
+    KeyPad_LenType inIndex;
+#if KEYPAD_USE_PORT
+    if (__useReadPort(keypad)) {
+        KeyPad_PortMask value = __readPort(keypad, &__inPin(keypad, 0), __inNum(keypad));
+        if (!state) {
+            value = ~value;
+        }
+        value &= __portMask(__inNum(keypad));
+        if (value) {
+            return (KeyPad_LenType) KEYPAD_CTZ(value);
+        }
+        return __INDEX_NONE;
+    }
+#endif // KEYPAD_USE_PORT
+    for (inIndex = 0; inIndex < __inNum(keypad); inIndex++) {
+        if (__readPin(keypad, &__inPin(keypad, inIndex)) == state) {
+            return inIndex;
+        }
+    }
+    return __INDEX_NONE;
+}
+#endif // !KEYPAD_NKRO
+#if KEYPAD_NKRO
+/**
+ * @brief read all inputs
+ * 
+ * @return KeyPad_PortMask active inputs, bit N is 1 if N-th input is in active state
+ */
+static KeyPad_PortMask KeyPad_readIn(KeyPad* keypad, uint8_t state) {
+    KeyPad_PortMask value = 0;
     KeyPad_LenType inIndex;
+#if KEYPAD_USE_PORT
+    if (__useReadPort(keypad)) {
+        value = __readPort(keypad, &__inPin(keypad, 0), __inNum(keypad));
+        if (!state) {
+            value = ~value;
+        }
+        return value & __portMask(__inNum(keypad));
+    }
+#endif // KEYPAD_USE_PORT
+    for (inIndex = 0; inIndex < __inNum(keypad); inIndex++) {
+        if (__readPin(keypad, &__inPin(keypad, inIndex)) == state) {
+            value |= (KeyPad_PortMask) 1 << inIndex;
+        }
+    }
+    return value;
+}
+#if !KEYPAD_SCAN_BUDGET
+/**
+ * @brief scan full matrix into a frame and fire changes
+ */
+static void KeyPad_scanFrame(KeyPad* keypad) {
+#if KEYPAD_SCAN_GROUP
+    if (!keypad->GroupScanned) {
+        // first keypad of group in this handle scan all of them
+        KeyPad_scanGroup(keypad);
+    }
+    keypad->GroupScanned = 0;
+    KeyPad_applyFrame(keypad, keypad->Scan);
+#else
+    KeyPad_PortMask frame[KEYPAD_NKRO_MAX_OUT];
+    KeyPad_LenType outIndex;
     uint8_t state = __activeState(keypad);
     for (outIndex = 0; outIndex < __outNum(keypad); outIndex++) {
-        keypadDriver->writePin(&__outPin(keypad, outIndex), state);
-        for (inIndex = 0; inIndex < __inNum(keypad); inIndex++) {
-            if (keypadDriver->readPin(&__inPin(keypad, inIndex)) == state) {
-                // key pressed
-                keypad->State = KeyPad_State_Pressed;
-                __setOutIndex(keypad, outIndex);
-                __setInIndex(keypad, inIndex);
-                __fireCallback(keypad, __value(keypad, outIndex, inIndex));
-                return;
+        frame[outIndex] = KeyPad_readOut(keypad, outIndex, state);
+    }
+    KeyPad_endFrame(keypad, frame, state);
+#endif // KEYPAD_SCAN_GROUP
+}
+#endif // !KEYPAD_SCAN_BUDGET
+#if !KEYPAD_SCAN_GROUP
+/**
+ * @brief read all inputs of an output
+ * 
+ * @return KeyPad_PortMask active inputs
+ */
+static KeyPad_PortMask KeyPad_readOut(KeyPad* keypad, KeyPad_LenType outIndex, uint8_t state) {
+    KeyPad_PortMask value;
+    KeyPad_strobeOut(keypad, outIndex, state);
+    value = KeyPad_readIn(keypad, state);
+    KeyPad_releaseOut(keypad, outIndex, state);
+    return value;
+}
+/**
+ * @brief release outputs and process scanned frame
+ */
+static void KeyPad_endFrame(KeyPad* keypad, KeyPad_PortMask* frame, uint8_t state) {
+    KeyPad_endStrobe(keypad, state);
+    KeyPad_applyFrame(keypad, frame);
+}
+#endif // !KEYPAD_SCAN_GROUP
+/**
+ * @brief process scanned frame, debounce it and fire changes
+ */
+static void KeyPad_applyFrame(KeyPad* keypad, KeyPad_PortMask* frame) {
+#if KEYPAD_DEBOUNCE
+    KeyPad_debounceFrame(keypad, frame);
+#endif // KEYPAD_DEBOUNCE
+    KeyPad_updateFrame(keypad, frame);
+}
+/**
+ * @brief clear pressed keys, handled keys and debounce counters of keypad
+ */
+static void KeyPad_resetFrame(KeyPad* keypad) {
+    KeyPad_LenType len = KEYPAD_NKRO_MAX_OUT;
+    while (len-- > 0) {
+        keypad->Frame[len] = 0;
+        keypad->Handled[len] = 0;
+    #if KEYPAD_DEBOUNCE
+        {
+            uint8_t bit = KEYPAD_DEBOUNCE_BITS;
+            while (bit-- > 0) {
+                keypad->Debounce[bit][len] = 0;
+            }
+        }
+    #endif // KEYPAD_DEBOUNCE
+    }
+}
+#if KEYPAD_SCAN_GROUP
+/**
+ * @brief drive each output of group once and read inputs of all keypads of group in same strobe
+ * frames stored in Scan of keypads and other keypads process them in their turn
+ */
+static void KeyPad_scanGroup(KeyPad* keypad) {
+    KeyPad* member;
+    KeyPad_LenType outIndex;
+    uint8_t state = __activeState(keypad);
+    for (outIndex = 0; outIndex < __outNum(keypad); outIndex++) {
+        KeyPad_strobeOut(keypad, outIndex, state);
+        member = keypad;
+        do {
+            if (__isEnabled(member)) {
+                member->Scan[outIndex] = KeyPad_readIn(member, state);
             }
+            member = member->GroupNext;
+        } while (member != keypad);
+        KeyPad_releaseOut(keypad, outIndex, state);
+    }
+    KeyPad_endStrobe(keypad, state);
+    for (member = keypad->GroupNext; member != keypad; member = member->GroupNext) {
+        if (__isEnabled(member)) {
+            member->GroupScanned = 1;
+        }
+    }
+}
+/**
+ * @brief add keypad to group of keypads that have same outputs
+ */
+static void KeyPad_joinGroup(KeyPad* keypad) {
+    KeyPad* pKeyPad;
+    keypad->GroupNext = keypad;
+    keypad->GroupScanned = 0;
+    __forEachKeyPad(pKeyPad) {
+        if (pKeyPad != keypad &&
+            &__outPin(pKeyPad, 0) == &__outPin(keypad, 0) &&
+            __outNum(pKeyPad) == __outNum(keypad) &&
+            __activeState(pKeyPad) == __activeState(keypad)) {
+            keypad->GroupNext = pKeyPad->GroupNext;
+            pKeyPad->GroupNext = keypad;
+            return;
         }
-        keypadDriver->writePin(&__outPin(keypad, outIndex), !state);
     }
+}
+/**
+ * @brief remove keypad from its group
+ */
+static void KeyPad_leaveGroup(KeyPad* keypad) {
+    KeyPad* pKeyPad = keypad;
+    while (pKeyPad->GroupNext != keypad) {
+        pKeyPad = pKeyPad->GroupNext;
+    }
+    pKeyPad->GroupNext = keypad->GroupNext;
+    keypad->GroupNext = keypad;
+}
+#endif // KEYPAD_SCAN_GROUP
+/**
+ * @brief compare new frame with last frame and fire callbacks for keys that changed
+ * Pressed for new keys and Released for released keys, only last pressed key fire Hold or long press and repeat
+ * so held keys are not visited in each handle
+ * 
+ * @param frame new frame, ghost keys will be removed from it
+ */
+static void KeyPad_updateFrame(KeyPad* keypad, KeyPad_PortMask* frame) {
+    KeyPad_LenType outIndex;
+    KeyPad_LenType inIndex;
+    KeyPad_PortMask active = 0;
+    // last pressed key, it's only key that fire hold, long press and repeat
+    KeyPad_LenType holdOut = __getOutIndex(keypad);
+    KeyPad_LenType holdIn = __getInIndex(keypad);
+    KeyPad_PortMask holdBit = keypad->Frame[holdOut] & ((KeyPad_PortMask) 1 << holdIn);
+#if KEYPAD_NKRO_GHOST
+    KeyPad_LenType otherIndex;
+    // two outputs that share 2 or more active inputs make a rectangle in matrix
+    // and one of the corners maybe is a ghost key
+    keypad->Ghost = 0;
+    for (outIndex = 0; outIndex < __outNum(keypad) && !keypad->Ghost; outIndex++) {
+        for (otherIndex = outIndex + 1; otherIndex < __outNum(keypad); otherIndex++) {
+            KeyPad_PortMask common = frame[outIndex] & frame[otherIndex];
+            if (common & (common - 1)) {
+                keypad->Ghost = 1;
+                break;
+            }
+        }
+    }
+    if (keypad->Ghost) {
+        // ignore new keys until matrix is not ambiguous
+        for (outIndex = 0; outIndex < __outNum(keypad); outIndex++) {
+            frame[outIndex] &= keypad->Frame[outIndex];
+        }
+    }
+#endif // KEYPAD_NKRO_GHOST
+    for (outIndex = 0; outIndex < __outNum(keypad); outIndex++) {
+        // only changed keys visited
+        KeyPad_PortMask keys = frame[outIndex] ^ keypad->Frame[outIndex];
+        keypad->Frame[outIndex] = frame[outIndex];
+        active |= frame[outIndex];
+        while (keys) {
+            KeyPad_PortMask bit;
+            KeyPad_State keyState;
+            // jump to next key of word
+            inIndex = (KeyPad_LenType) KEYPAD_CTZ(keys);
+            bit = (KeyPad_PortMask) 1 << inIndex;
+            keys &= ~bit;
+            keyState = (frame[outIndex] & bit) == 0 ? KeyPad_State_Released : KeyPad_State_Pressed;
+        #if KEYPAD_CHORD
+            if (KeyPad_chordKey(keypad, outIndex, inIndex, keyState))
+        #endif // KEYPAD_CHORD
+            KeyPad_fireKey(keypad, outIndex, inIndex, keyState);
+        }
+    }
+    // fire hold, or long press and repeat, if last pressed key still hold and no other key pressed
+    if ((keypad->Frame[holdOut] & holdBit) != 0 &&
+        holdOut == __getOutIndex(keypad) && holdIn == __getInIndex(keypad)) {
+    #if KEYPAD_HOLD_REPEAT
+        KeyPad_State event = KeyPad_holdEvent(keypad);
+        if (event != KeyPad_State_None) {
+            KeyPad_fireKey(keypad, holdOut, holdIn, event);
+        }
+    #else
+    #if KEYPAD_CHORD
+        if (KeyPad_chordKey(keypad, holdOut, holdIn, KeyPad_State_Hold))
+    #endif // KEYPAD_CHORD
+        KeyPad_fireKey(keypad, holdOut, holdIn, KeyPad_State_Hold);
+    #endif // KEYPAD_HOLD_REPEAT
+    }
+#if KEYPAD_CHORD
+    if (keypad->ChordPending) {
+        // held back keys wait until window of candidate chords passed
+        uint32_t ticks = (uint32_t) keypad->ChordTicks + __elapsed();
+        keypad->ChordTicks = ticks > 0xFFFF ? 0xFFFF : (uint16_t) ticks;
+        KeyPad_matchChord(keypad);
+    }
+#endif // KEYPAD_CHORD
+    keypad->State = active ? KeyPad_State_Hold : KeyPad_State_None;
     // fire callback if state is none
     __fireNoneCallback(keypad);
 }
-
+/**
+ * @brief fire callback of a key in nkro mode
+ */
+static void KeyPad_fireKey(KeyPad* keypad, KeyPad_LenType outIndex, KeyPad_LenType inIndex, KeyPad_State state) {
+#if KEYPAD_HOLD_REPEAT
+    keypad->State = state < KeyPad_State_LongPress ? state : KeyPad_State_Hold;
+#else
+    keypad->State = state;
+#endif // KEYPAD_HOLD_REPEAT
+    if (state == KeyPad_State_Pressed) {
+        // track last pressed key for hold, long press and repeat
+        __setOutIndex(keypad, outIndex);
+        __setInIndex(keypad, inIndex);
+        __resetHold(keypad);
+    }
+#if KEYPAD_EVENT_QUEUE
+    KeyPad_pushEvent(keypad, outIndex, inIndex, __value(keypad, outIndex, inIndex), state);
+#else
+    if (state == KeyPad_State_Pressed) {
+        __pressLatency();
+    }
+    KeyPad_callKey(keypad, outIndex, inIndex, __value(keypad, outIndex, inIndex), state);
+#endif // KEYPAD_EVENT_QUEUE
+}
+#if KEYPAD_DEBOUNCE
+/**
+ * @brief filter new frame with bit-sliced counters, each key has KEYPAD_DEBOUNCE_BITS counter
+ * counter of a key increase while it's differ from last frame and reset when it's same
+ * key toggle when counter overflow
+ * 
+ * @param frame raw frame, replace with debounced frame
+ */
+static void KeyPad_debounceFrame(KeyPad* keypad, KeyPad_PortMask* frame) {
+    KeyPad_LenType outIndex;
+    uint8_t bit;
+    for (outIndex = 0; outIndex < __outNum(keypad); outIndex++) {
+        KeyPad_PortMask delta = frame[outIndex] ^ keypad->Frame[outIndex];
+        KeyPad_PortMask carry = delta;
+        for (bit = 0; bit < KEYPAD_DEBOUNCE_BITS; bit++) {
+            KeyPad_PortMask count = keypad->Debounce[bit][outIndex];
+            keypad->Debounce[bit][outIndex] = (count ^ carry) & delta;
+            carry &= count;
+        }
+        frame[outIndex] = keypad->Frame[outIndex] ^ carry;
+    }
+}
+#endif // KEYPAD_DEBOUNCE
+#if KEYPAD_CHORD
+/**
+ * @brief pass event of a key through chords, pressed event of chord keys held back
+ * and events of keys that used in matched chord ignored
+ * 
+ * @return uint8_t 1 if event must fire as single key event
+ */
+static uint8_t KeyPad_chordKey(KeyPad* keypad, KeyPad_LenType outIndex, KeyPad_LenType inIndex, KeyPad_State state) {
+    const KeyPad_Chords* chords = keypad->Chords;
+    KeyPad_KeyIndex key;
+    KeyPad_ChordMask bit;
+    if (KEYPAD_CHORDS_NULL == chords) {
+        return 1;
+    }
+    key = __keyIndex(keypad, outIndex, inIndex);
+    bit = key < KEYPAD_CHORD_KEYS ? (KeyPad_ChordMask) 1 << key : 0;
+    if ((chords->Keys & bit) == 0) {
+        // other keys break chord, fire held back keys before it to keep order
+        if (state == KeyPad_State_Pressed) {
+            KeyPad_flushChord(keypad);
+        }
+        return 1;
+    }
+    switch (state) {
+        case KeyPad_State_Pressed:
+            if (keypad->ChordPending == 0) {
+                keypad->ChordTicks = 0;
+            }
+            keypad->ChordDown |= bit;
+            keypad->ChordPending |= bit;
+            keypad->ChordRules &= chords->KeyRules[key];
+            KeyPad_matchChord(keypad);
+            return 0;
+        case KeyPad_State_Released:
+            if (keypad->ChordPending & bit) {
+                // key released before chord matched, it was a single key
+                KeyPad_flushChord(keypad);
+            }
+            keypad->ChordDown &= ~bit;
+            keypad->ChordRules = KeyPad_chordRules(chords, keypad->ChordDown);
+            if (keypad->ChordIndex != KEYPAD_CHORD_NONE && (chords->Table[keypad->ChordIndex].Keys & bit) != 0) {
+                // chord end with release of first key of it
+                KeyPad_fireChord(keypad, keypad->ChordIndex, KeyPad_State_Released);
+                keypad->ChordIndex = KEYPAD_CHORD_NONE;
+            }
+            if (keypad->ChordUsed & bit) {
+                keypad->ChordUsed &= ~bit;
+                __count(keypad, Suppressed);
+                return 0;
+            }
+            return 1;
+        default:
+            if ((keypad->ChordPending | keypad->ChordUsed) & bit) {
+                __count(keypad, Suppressed);
+                return 0;
+            }
+            return 1;
+    }
+}
+/**
+ * @brief check candidate chords, fire chord that exactly match pressed keys
+ * and fire held back keys if no candidate chord remain in its window
+ */
+static void KeyPad_matchChord(KeyPad* keypad) {
+    const KeyPad_Chords* chords = keypad->Chords;
+    KeyPad_ChordRules rules = keypad->ChordRules;
+    uint8_t wait = 0;
+    uint8_t index;
+    if (keypad->ChordDown & ~(keypad->ChordPending | keypad->ChordUsed)) {
+        // a pressed key fired as single key, so it can't be part of a chord
+        rules = 0;
+    }
+    while (rules) {
+        index = KEYPAD_CTZ(rules);
+        rules &= rules - 1;
+        if (index >= chords->Len) {
+            break;
+        }
+        if (keypad->ChordTicks <= chords->Table[index].Window) {
+            if (chords->Table[index].Keys == keypad->ChordDown) {
+                if (keypad->ChordIndex != KEYPAD_CHORD_NONE) {
+                    // bigger chord replace last chord
+                    KeyPad_fireChord(keypad, keypad->ChordIndex, KeyPad_State_Released);
+                }
+                keypad->ChordIndex = index;
+                keypad->ChordUsed |= keypad->ChordPending;
+                keypad->ChordPending = 0;
+                KeyPad_fireChord(keypad, index, KeyPad_State_Pressed);
+                return;
+            }
+            // candidate has more keys
+            wait = 1;
+        }
+    }
+    if (!wait) {
+        KeyPad_flushChord(keypad);
+    }
+}
+/**
+ * @brief fire pressed event of held back keys
+ */
+static void KeyPad_flushChord(KeyPad* keypad) {
+    KeyPad_ChordMask pending = keypad->ChordPending;
+    KeyPad_KeyIndex key;
+    keypad->ChordPending = 0;
+    while (pending) {
+        key = KEYPAD_CTZ(pending);
+        pending &= pending - 1;
+        KeyPad_fireKey(keypad, (KeyPad_LenType) __keyOut(keypad, key), (KeyPad_LenType) __keyIn(keypad, key), KeyPad_State_Pressed);
+    }
+}
+/**
+ * @brief fire event of a chord, in event queue mode chord index pass as input index without output index
+ */
+static void KeyPad_fireChord(KeyPad* keypad, uint8_t index, KeyPad_State state) {
+#if KEYPAD_EVENT_QUEUE
+    KeyPad_pushEvent(keypad, __INDEX_NONE, (KeyPad_LenType) index, keypad->Chords->Table[index].Value, state);
+#else
+    KeyPad_callChord(keypad, keypad->Chords->Table[index].Value, state);
+#endif // KEYPAD_EVENT_QUEUE
+}
+static void KeyPad_callChord(KeyPad* keypad, KeyPad_KeyValue value, KeyPad_State state) {
+    if (keypad->ChordCallback && !__isRemoved(keypad)) {
+        __count(keypad, Callbacks);
+        keypad->ChordCallback(keypad, value, state);
+    }
+}
+/**
+ * @brief find chords that have all of keys
+ */
+static KeyPad_ChordRules KeyPad_chordRules(const KeyPad_Chords* chords, KeyPad_ChordMask keys) {
+    KeyPad_ChordRules rules = (KeyPad_ChordRules) ~0;
+    while (keys) {
+        rules &= chords->KeyRules[KEYPAD_CTZ(keys)];
+        keys &= keys - 1;
+    }
+    return rules;
+}
+#endif // KEYPAD_CHORD
+#endif // KEYPAD_NKRO
+#if KEYPAD_HOLD_REPEAT
+/**
+ * @brief count ticks of held key and return long press or repeat when it's time
+ * 
+ * @return KeyPad_State KeyPad_State_None if there is no event in this tick
+ */
+static KeyPad_State KeyPad_holdEvent(KeyPad* keypad) {
+    uint16_t delay = keypad->LongPressed ? keypad->RepeatDelay : keypad->HoldDelay;
+    uint32_t ticks;
+    if (keypad->HoldDelay == 0 || delay == 0) {
+        return KeyPad_State_None;
+    }
+    ticks = (uint32_t) keypad->HoldTicks + __elapsed();
+    if (ticks < delay) {
+        keypad->HoldTicks = (uint16_t) ticks;
+        return KeyPad_State_None;
+    }
+    keypad->HoldTicks = 0;
+    if (!keypad->LongPressed) {
+        keypad->LongPressed = 1;
+        return KeyPad_State_LongPress;
+    }
+    return KeyPad_State_Repeat;
+}
+#endif // KEYPAD_HOLD_REPEAT
+#if KEYPAD_NKRO || KEYPAD_EVENT_QUEUE
+/**
+ * @brief fire callback of a key and ignore hold and released of keys that user handled them
+ */
+static void KeyPad_callKey(KeyPad* keypad, KeyPad_LenType outIndex, KeyPad_LenType inIndex, KeyPad_KeyValue value, KeyPad_State state) {
+#if KEYPAD_NKRO
+    KeyPad_PortMask bit;
+    if (state == KeyPad_State_None) {
+        KeyPad_callback(keypad, value, state);
+        return;
+    }
+    bit = (KeyPad_PortMask) 1 << inIndex;
+    if (state == KeyPad_State_Pressed || (keypad->Handled[outIndex] & bit) == 0) {
+        if (KeyPad_callback(keypad, value, state) == KeyPad_Handled && state != KeyPad_State_Released) {
+            keypad->Handled[outIndex] |= bit;
+        }
+        else {
+            keypad->Handled[outIndex] &= ~bit;
+        }
+    }
+    else {
+        __count(keypad, Suppressed);
+        if (state == KeyPad_State_Released) {
+            keypad->Handled[outIndex] &= ~bit;
+        }
+    }
+#else
+    // single key mode has only one key, its indices are in keypad
+    (void) outIndex;
+    (void) inIndex;
+    if (state == KeyPad_State_Pressed || state == KeyPad_State_None || !keypad->Handled) {
+        keypad->Handled = KeyPad_callback(keypad, value, state);
+    }
+    else {
+        __count(keypad, Suppressed);
+    }
+#endif // KEYPAD_NKRO
+}
+/**
+ * @brief call user callback of state
+ * 
+ * @return KeyPad_HandleStatus result of user callback
+ */
+static KeyPad_HandleStatus KeyPad_callback(KeyPad* keypad, KeyPad_KeyValue value, KeyPad_State state) {
+    if (__isRemoved(keypad)) {
+        // other callback of frame removed keypad
+        return KeyPad_NotHandled;
+    }
+#if KEYPAD_MULTI_CALLBACK
+    if (state < KEYPAD_CALLBACKS_NUM && __callbacks(keypad).fn[state]) {
+        __count(keypad, Callbacks);
+        return __callbacks(keypad).fn[state](keypad, value, state);
+    }
+#else
+    if (__callbacks(keypad).onChange) {
+        __count(keypad, Callbacks);
+        return __callbacks(keypad).onChange(keypad, value, state);
+    }
+#endif // KEYPAD_MULTI_CALLBACK
+    return KeyPad_NotHandled;
+}
+#endif // KEYPAD_NKRO || KEYPAD_EVENT_QUEUE
+#if KEYPAD_EVENT_QUEUE
+/**
+ * @brief push event into queue, it's only producer of queue
+ * event drop if queue is full
+ */
+static void KeyPad_pushEvent(KeyPad* keypad, KeyPad_LenType outIndex, KeyPad_LenType inIndex, KeyPad_KeyValue value, KeyPad_State state) {
+    KeyPad_EventQueue* queue = __queue(keypad);
+    uint16_t head = queue->Head;
+    KeyPad_Event* event;
+    if ((uint16_t) (head - queue->Tail) >= KEYPAD_EVENT_QUEUE_SIZE) {
+        queue->Overflow++;
+        return;
+    }
+    event = &queue->Events[head & (KEYPAD_EVENT_QUEUE_SIZE - 1)];
+    event->Keypad = keypad;
+    event->Tick = __tick(keypad);
+    event->Value = value;
+    event->OutIndex = outIndex;
+    event->InIndex = inIndex;
+    event->State = (uint8_t) state;
+#if KEYPAD_STATS
+    event->Cycles = keypadHandleStart;
+#endif // KEYPAD_STATS
+    // publish event after write it
+    KEYPAD_MEMORY_BARRIER();
+    queue->Head = head + 1;
+}
+#endif // KEYPAD_EVENT_QUEUE
+#if KEYPAD_STATS
+/**
+ * @brief add a sample into histogram
+ * 
+ * @param cycles duration in cycles of user clock
+ */
+static void KeyPad_sample(KeyPad_Histogram* histogram, uint32_t cycles) {
+    uint8_t bin = 0;
+    while (bin < KEYPAD_STATS_BINS - 1 && (cycles >> (bin + 1)) != 0) {
+        bin++;
+    }
+    histogram->Bins[bin]++;
+    histogram->Count++;
+    histogram->Sum += cycles;
+    if (histogram->Max < cycles) {
+        histogram->Max = cycles;
+    }
+}
+#endif // KEYPAD_STATS
+/**
+ * @brief count trailing zeros of a non-zero mask, KEYPAD_CTZ use it when compiler has no builtin
+ * it skip zero bytes first, so it's cheap on 8-bit cpus too
+ */
+uint8_t KeyPad_ctz(uint64_t value) {
+    uint8_t count = 0;
+    while ((value & 0xFF) == 0) {
+        value >>= 8;
+        count += 8;
+    }
+    while ((value & 1) == 0) {
+        value >>= 1;
+        count++;
+    }
+    return count;
+}
@@ -44,10 +44,59 @@ extern "C" {
  */
 #define KEYPAD_NONE_CALLBACK	            0
 
+/**
+ * @brief keypad hold pointer to a const callback table instead of its own callbacks
+ * keypads with same handlers share one table in flash, set it with KeyPad_setCallbacks
+ */
+#define KEYPAD_SHARED_CALLBACKS             0
+
 /**
  * @brief user must define deinitPin function in KeyPad_Driver
  */
 #define KEYPAD_USE_DEINIT	                0
+/**
+ * @brief user can define readPort and writePort functions in KeyPad_Driver
+ * scan use them for read/write a group of pins in one call if they are not null
+ */
+#define KEYPAD_USE_PORT                     0
+/**
+ * @brief keep last written level of outputs of each keypad and skip writes that don't change level
+ * library must be only writer of output pins, outputs more than bits of KeyPad_PortMask always written
+ */
+#define KEYPAD_OUT_SHADOW                   0
+/**
+ * @brief enable debounce stage between read inputs and state machine
+ * state of a key change after 2^KEYPAD_DEBOUNCE_BITS continuous same reads
+ * so handle can place in faster timer without chatter
+ */
+#define KEYPAD_DEBOUNCE                     0
+/**
+ * @brief number of bits of debounce counter for each key
+ */
+#define KEYPAD_DEBOUNCE_BITS                2
+/**
+ * @brief when all keypads are idle, KeyPad_handle drive all outputs active and enable wake on inputs
+ * then it skip scan until KeyPad_wake call from input edge irq
+ * user must define setWakePin function in KeyPad_Driver
+ */
+#define KEYPAD_IDLE_WAKE                    0
+/**
+ * @brief add KeyPad_handleAt that get current tick and return tick that it must call again
+ * so user can schedule it in tickless rtos or event loop instead of fixed timer
+ */
+#define KEYPAD_ADAPTIVE_RATE                0
+/**
+ * @brief ticks between handles when no key is pressed
+ */
+#define KEYPAD_IDLE_PERIOD                  50
+/**
+ * @brief ticks between handles while key changing or wait for debounce
+ */
+#define KEYPAD_ACTIVE_PERIOD                5
+/**
+ * @brief ticks between handles while keys are hold
+ */
+#define KEYPAD_HOLD_PERIOD                  20
 /**
  * @brief if KeyPad is based on pair of GPIO and Pin num must enable it
  * for arduino must disable it
@@ -68,12 +117,114 @@ typedef void* KeyPad_IO;
  */
 typedef uint16_t KeyPad_Pin;
 
+/**
+ * @brief hold state of a group of pins, bit N show state of N-th pin
+ * number of inputs and outputs of keypad must be less than or equal bits of KeyPad_PortMask
+ * when readPort or writePort is used, user can change it to uint64_t for 64 inputs
+ */
+typedef uint32_t KeyPad_PortMask;
+/**
+ * @brief count trailing zeros of a non-zero mask, bitmaps jump to next set bit with it
+ * so cost of scan and diff grow with words and set bits, not with keys
+ * compilers without builtin use KeyPad_ctz loop
+ */
+#if defined(__GNUC__) || defined(__clang__)
+    #define KEYPAD_CTZ(X)                   ((uint8_t) __builtin_ctzll(X))
+#else
+    #define KEYPAD_CTZ(X)                   KeyPad_ctz((uint64_t) (X))
+#endif
+
+/**
+ * @brief hold result of adc conversion, just useful in analog mode
+ */
+typedef uint16_t KeyPad_AnalogValue;
+
+/**
+ * @brief hold tick counter, each KeyPad_handle call is one tick
+ */
+typedef uint32_t KeyPad_Tick;
+
 /**
  * @brief maximum number of keypads
- * -1 for unlimited, lib use linked list 
- * x for limited keypads, lib use pointer array
+ * -1 for unlimited, lib use doubly linked list 
+ * x for limited keypads, lib use array of keypads with free slot bitmap and dense list of active keypads
  */
 #define KEYPAD_MAX_NUM                     -1
+/**
+ * @brief hold number of keypads and index of keypad in fixed mode
+ */
+#if KEYPAD_MAX_NUM > 255
+    typedef uint16_t KeyPad_NumType;
+#else
+    typedef uint8_t KeyPad_NumType;
+#endif
+
+/**
+ * @brief maximum number of outputs that each KeyPad_handle scan across all keypads
+ * scan of keypads continue in next calls round-robin, so time of KeyPad_handle is bounded
+ * 0 for disable, KeyPad_handle scan all keypads in each call
+ */
+#define KEYPAD_SCAN_BUDGET                  0
+/**
+ * @brief keypads with Settle in config scan one output in each handle
+ * output strobe in a handle and inputs read after Settle handles, so settle time of lines overlap with other works
+ * can't use with KEYPAD_SCAN_BUDGET and KEYPAD_SCAN_GROUP
+ */
+#define KEYPAD_SCAN_PIPELINE                0
+
+/**
+ * @brief KeyPad_handle only push events into a lock-free queue and KeyPad_dispatch fire callbacks
+ * so KeyPad_handle can place in timer irq and KeyPad_dispatch in main loop or another thread
+ */
+#define KEYPAD_EVENT_QUEUE                  0
+/**
+ * @brief number of events that queue can hold, must be power of 2
+ */
+#define KEYPAD_EVENT_QUEUE_SIZE             16
+/**
+ * @brief memory barrier that use between write data and publish it to other context
+ */
+#define KEYPAD_MEMORY_BARRIER()             __sync_synchronize()
+/**
+ * @brief atomic load with acquire and store with release, KEYPAD_CONCURRENT use them for pointers and flags
+ * that one context publish and other context read, default use gcc and clang builtins, C11 compilers can use atomic_load_explicit
+ */
+#define KEYPAD_LOAD_ACQUIRE(P)              __atomic_load_n(&(P), __ATOMIC_ACQUIRE)
+#define KEYPAD_STORE_RELEASE(P, V)          __atomic_store_n(&(P), (V), __ATOMIC_RELEASE)
+/**
+ * @brief atomic add that return old value, it's acquire and release, KeyPad_handle and KeyPad_remove meet on it
+ */
+#define KEYPAD_FETCH_ADD(P, V)              __atomic_fetch_add(&(P), (V), __ATOMIC_ACQ_REL)
+/**
+ * @brief KeyPad_add, KeyPad_remove and KeyPad_setConfig can call from another context while KeyPad_handle run in irq or thread
+ * added keypad publish by pointer store after init, removed keypad unlink at once and its pins release after running KeyPad_handle
+ * new config apply by KeyPad_handle before a scan of keypad that no key is pressed, only one context (or callbacks) can add, remove or set config
+ * just work in linked list mode (KEYPAD_MAX_NUM -1) without KEYPAD_SCAN_BUDGET and KEYPAD_SCAN_GROUP
+ */
+#define KEYPAD_CONCURRENT                   0
+/**
+ * @brief number of keypads that can remove while a KeyPad_handle run, must be power of 2
+ * KeyPad_remove return 0 when it's full, keypad can remove again after KeyPad_handle
+ */
+#define KEYPAD_RETIRE_SIZE                  4
+/**
+ * @brief keypads can handle in some threads, each thread call KeyPad_handleShard with its own KeyPad_Shard
+ * keypads split into contiguous blocks by position in list, each shard has own tick and event queue
+ * so threads share nothing that change while handle, keypads must not add or remove while shards running
+ * each KeyPad_Context has own keypads and driver, so a process can have independent populations of keypads
+ * just work in fixed mode (KEYPAD_MAX_NUM > 0) without KEYPAD_SCAN_BUDGET, KEYPAD_SCAN_GROUP, KEYPAD_ADAPTIVE_RATE and KEYPAD_STATS
+ */
+#define KEYPAD_SHARD                        0
+
+/**
+ * @brief count scans, pin accesses and callbacks of each keypad and all keypads
+ * and record histograms of KeyPad_handle duration and press-to-callback latency with user clock
+ */
+#define KEYPAD_STATS                        0
+/**
+ * @brief number of bins of histograms, bin N count samples in [2^N, 2^(N+1)) cycles
+ */
+#define KEYPAD_STATS_BINS                   16
 
 /**
  * @brief user can store some args in keypad struct and retrive them in callbacks
@@ -87,14 +238,99 @@ typedef uint16_t KeyPad_Pin;
  */
 #define KEYPAD_MODE                         KEYPAD_MODE_ROW_INPUT
 
+/**
+ * @brief enable n-key rollover mode, library scan full matrix in each handle
+ * and fire callbacks for every key that changed, so multiple keys can be hold together
+ * number of inputs must be less than or equal bits of KeyPad_PortMask and outputs less than or equal KEYPAD_NKRO_MAX_OUT,
+ * KeyPad_add reject bigger configs, change KeyPad_PortMask to uint64_t for 64 inputs
+ */
+#define KEYPAD_NKRO                         0
+/**
+ * @brief maximum number of outputs of a keypad in nkro mode
+ */
+#define KEYPAD_NKRO_MAX_OUT                 8
+/**
+ * @brief ignore new pressed keys when matrix is ambiguous
+ * use it for matrices without diodes
+ */
+#define KEYPAD_NKRO_GHOST                   1
+/**
+ * @brief keypads that use same output pins array (and active state) make a scan group
+ * each output of group drive once in each handle and inputs of all keypads read in same strobe
+ * just work in nkro mode without KEYPAD_SCAN_BUDGET
+ */
+#define KEYPAD_SCAN_GROUP                   0
+
+/**
+ * @brief fire KeyPad_State_LongPress once after hold delay and KeyPad_State_Repeat in each repeat interval
+ * instead of fire KeyPad_State_Hold in each handle, delays are in ticks and can set for each keypad
+ * each KeyPad_handle is one tick, KeyPad_handleAt use ticks of user
+ * in nkro mode only last pressed key fire long press and repeat events
+ */
+#define KEYPAD_HOLD_REPEAT                  0
+/**
+ * @brief default number of ticks that key must hold before long press event, 0 disable long press and repeat
+ */
+#define KEYPAD_HOLD_DELAY                   50
+/**
+ * @brief default number of ticks between repeat events after long press, 0 disable repeat
+ */
+#define KEYPAD_REPEAT_DELAY                 10
+
+/**
+ * @brief match pressed keys with a table of chords (key combinations), matched chord fire chord callback
+ * and its keys not fire single key events, pressed event of chord keys held back until chord matched or window passed
+ * just work in KEYPAD_NKRO
+ */
+#define KEYPAD_CHORD                        0
+
+/**
+ * @brief user can capture frame of keypad by hardware (ex: timer and dma) and pass it to KeyPad_processFrame
+ * instead of KeyPad_handle, KeyPad_strobePattern make output values of each strobe for hardware
+ * just work in KEYPAD_NKRO
+ */
+#define KEYPAD_FRAME_CAPTURE                0
+
+/**
+ * @brief keypads with Thresholds in config are analog keypads, each input is adc pin of a resistor ladder
+ * and each level of ladder is an output of keypad, so a conversion replace strobe of outputs
+ * user must define readAnalog function in KeyPad_Driver, just work without KEYPAD_NKRO
+ */
+#define KEYPAD_ANALOG                       0
+
+/**
+ * @brief maximum number of rows or columns of a keypad, at most 32767
+ * KeyPad_LenType widen to int16_t above 127 and KeyPad_KeyIndex widen to uint32_t above 255
+ */
+#define KEYPAD_MAX_LEN                      127
+/**
+ * @brief maximum value of keys in maps, KeyPad_KeyValue widen to int16_t above 127
+ */
+#define KEYPAD_MAX_KEY_VALUE                127
 /**
  * @brief hold keypad value
  */
-typedef int8_t KeyPad_KeyValue;
+#if KEYPAD_MAX_KEY_VALUE > 127
+    typedef int16_t KeyPad_KeyValue;
+#else
+    typedef int8_t KeyPad_KeyValue;
+#endif
 /**
  * @brief hold keypad len type
  */
-typedef int8_t KeyPad_LenType;
+#if KEYPAD_MAX_LEN > 127
+    typedef int16_t KeyPad_LenType;
+#else
+    typedef int8_t KeyPad_LenType;
+#endif
+/**
+ * @brief hold index of key in map, it hold RowsLen * ColumnsLen
+ */
+#if KEYPAD_MAX_LEN > 255
+    typedef uint32_t KeyPad_KeyIndex;
+#else
+    typedef uint16_t KeyPad_KeyIndex;
+#endif
 /**
  * @brief KeyPad key none value
  */
@@ -124,6 +360,8 @@ typedef enum {
     KeyPad_State_Hold          = 0x01,
     KeyPad_State_Released      = 0x02,
     KeyPad_State_None          = 0x03,
+    KeyPad_State_LongPress     = 0x04,      /**< key hold for hold delay, just in KEYPAD_HOLD_REPEAT */
+    KeyPad_State_Repeat        = 0x05,      /**< key still hold after long press, just in KEYPAD_HOLD_REPEAT */
 } KeyPad_State;
 
 /**
@@ -144,6 +382,7 @@ typedef enum {
     KeyPad_PinMode_InputPullUp      = 0,
     KeyPad_PinMode_InputPullDown    = 1,  
     KeyPad_PinMode_Output           = 2,
+    KeyPad_PinMode_Analog           = 3,      /**< adc input, just in KEYPAD_ANALOG */
 } KeyPad_PinMode;
 
 /**
@@ -162,9 +401,35 @@ typedef struct {
     const KeyPad_PinConfig*     Rows;
     KeyPad_LenType              ColumnsLen;
     KeyPad_LenType              RowsLen;
+#if KEYPAD_SCAN_PIPELINE
+    uint8_t                     Settle;             /**< handles between strobe of output and read inputs, 0 scan all outputs in one handle */
+#endif // KEYPAD_SCAN_PIPELINE
+#if KEYPAD_ANALOG
+    const KeyPad_AnalogValue*   Thresholds;         /**< ascending upper bounds of ladder levels, one for each output, null for matrix keypads */
+    KeyPad_AnalogValue          Hysteresis;         /**< new key must be this far from bounds of its level, pressed key release this far out of them */
+#endif // KEYPAD_ANALOG
 } KeyPad_Config;
 
 #define KEYPAD_CONFIG_INIT(MAP, COL, ROW)       {MAP, COL, ROW, sizeof(COL)/sizeof(KeyPad_PinConfig), sizeof(ROW)/sizeof(KeyPad_PinConfig)}
+#if KEYPAD_SCAN_PIPELINE
+    #define KEYPAD_CONFIG_INIT_SETTLE(MAP, COL, ROW, SETTLE)    {MAP, COL, ROW, sizeof(COL)/sizeof(KeyPad_PinConfig), sizeof(ROW)/sizeof(KeyPad_PinConfig), SETTLE}
+#endif // KEYPAD_SCAN_PIPELINE
+#if KEYPAD_ANALOG
+#if KEYPAD_SCAN_PIPELINE
+    #define __KEYPAD_CONFIG_SETTLE              0,
+#else
+    #define __KEYPAD_CONFIG_SETTLE
+#endif // KEYPAD_SCAN_PIPELINE
+/**
+ * @brief config of analog keypad, PINS are adc inputs and THRESHOLDS are bounds of levels of each input
+ * map has a row of levels for each input in KEYPAD_MODE_ROW_INPUT
+ */
+#if KEYPAD_MODE == KEYPAD_MODE_ROW_INPUT
+    #define KEYPAD_CONFIG_INIT_ANALOG(MAP, PINS, THRESHOLDS, HYSTERESIS)    {MAP, KEYPAD_CONFIG_NULL, PINS, sizeof(THRESHOLDS)/sizeof(KeyPad_AnalogValue), sizeof(PINS)/sizeof(KeyPad_PinConfig), __KEYPAD_CONFIG_SETTLE THRESHOLDS, HYSTERESIS}
+#else
+    #define KEYPAD_CONFIG_INIT_ANALOG(MAP, PINS, THRESHOLDS, HYSTERESIS)    {MAP, PINS, KEYPAD_CONFIG_NULL, sizeof(PINS)/sizeof(KeyPad_PinConfig), sizeof(THRESHOLDS)/sizeof(KeyPad_AnalogValue), __KEYPAD_CONFIG_SETTLE THRESHOLDS, HYSTERESIS}
+#endif
+#endif // KEYPAD_ANALOG
 
 /* Pre-Defined data types*/
 struct _KeyPad;
@@ -191,6 +456,26 @@ typedef uint8_t (*KeyPad_ReadPinFn)(const KeyPad_PinConfig* config);
  * 0 -> LOW, !0 -> HIGH
  */
 typedef void (*KeyPad_WritePinFn)(const KeyPad_PinConfig* config, uint8_t value);
+/**
+ * @brief this function must return value of a group of pins
+ * bit N of result is value of configs[N], 0 -> LOW, 1 -> HIGH
+ */
+typedef KeyPad_PortMask (*KeyPad_ReadPortFn)(const KeyPad_PinConfig* configs, KeyPad_LenType len);
+/**
+ * @brief this function must set state of a group of pins
+ * bit N of value is state of configs[N], 0 -> LOW, 1 -> HIGH
+ */
+typedef void (*KeyPad_WritePortFn)(const KeyPad_PinConfig* configs, KeyPad_LenType len, KeyPad_PortMask value);
+/**
+ * @brief this function must enable or disable edge interrupt of input pin
+ * user must call KeyPad_wake in interrupt
+ */
+typedef void (*KeyPad_SetWakePinFn)(const KeyPad_PinConfig* config, uint8_t enable);
+/**
+ * @brief this function must convert voltage of adc pin and return result
+ * result compare with thresholds of config of keypad
+ */
+typedef KeyPad_AnalogValue (*KeyPad_ReadAnalogFn)(const KeyPad_PinConfig* config);
 /**
  * @brief this callback call when keypad state change
  * 
@@ -201,6 +486,112 @@ typedef void (*KeyPad_WritePinFn)(const KeyPad_PinConfig* config, uint8_t value)
  *                  otherwise can return KeyPad_Handled (1) that mean keypad handled nad next event is onPressed
  */
 typedef KeyPad_HandleStatus (*KeyPad_Callback)(KeyPad* keypad, KeyPad_KeyValue value, KeyPad_State state);
+#if KEYPAD_CHORD
+/**
+ * @brief hold set of keys, bit N is key N of Map
+ */
+typedef uint32_t KeyPad_ChordMask;
+/**
+ * @brief hold set of chords, bit N is chord N of table
+ */
+typedef uint32_t KeyPad_ChordRules;
+/**
+ * @brief maximum number of keys and chords that can use in chords
+ */
+#define KEYPAD_CHORD_KEYS                   ((uint8_t) (sizeof(KeyPad_ChordMask) * 8))
+#define KEYPAD_CHORD_MAX                    ((uint8_t) (sizeof(KeyPad_ChordRules) * 8))
+#define KEYPAD_CHORD_NONE                   0xFF
+#define KEYPAD_CHORDS_NULL                  ((KeyPad_Chords*) 0)
+/**
+ * @brief hold a chord, it matched when exactly its keys pressed
+ */
+typedef struct {
+    KeyPad_ChordMask            Keys;                       /**< keys of chord, bit N is key N of Map */
+    uint16_t                    Window;                     /**< maximum ticks from first held back key to last key of chord */
+    KeyPad_KeyValue             Value;                      /**< value that pass to chord callback */
+} KeyPad_Chord;
+/**
+ * @brief hold chord table and index of it, fill it with KeyPad_initChords
+ * keypads with same map can share it
+ */
+typedef struct {
+    const KeyPad_Chord*         Table;                      /**< chords, first chord win when some chords matched */
+    KeyPad_ChordMask            Keys;                       /**< keys that used in chords */
+    KeyPad_ChordRules           KeyRules[KEYPAD_CHORD_KEYS]; /**< chords of each key, bit N is chord N of table */
+    uint8_t                     Len;                        /**< number of chords */
+} KeyPad_Chords;
+#endif // KEYPAD_CHORD
+#if KEYPAD_EVENT_QUEUE
+/**
+ * @brief hold an event of keypad in event queue
+ */
+typedef struct {
+    KeyPad*                     Keypad;                     /**< keypad that fire event */
+    KeyPad_Tick                 Tick;                       /**< tick of KeyPad_handle that event happened */
+    KeyPad_KeyValue             Value;                      /**< key value hold in map */
+    KeyPad_LenType              OutIndex;                   /**< index of output pin of key */
+    KeyPad_LenType              InIndex;                    /**< index of input pin of key */
+    uint8_t                     State;                      /**< state of key */
+#if KEYPAD_STATS
+    uint32_t                    Cycles;                     /**< user clock at start of KeyPad_handle that fire event */
+#endif // KEYPAD_STATS
+} KeyPad_Event;
+/**
+ * @brief single producer and single consumer queue of events
+ */
+typedef struct {
+    KeyPad_Event                Events[KEYPAD_EVENT_QUEUE_SIZE];
+    volatile uint16_t           Head;                       /**< only producer change it */
+    volatile uint16_t           Tail;                       /**< only dispatcher change it */
+    volatile uint32_t           Overflow;                   /**< number of events that dropped because queue was full */
+} KeyPad_EventQueue;
+#endif // KEYPAD_EVENT_QUEUE
+#if KEYPAD_SHARD
+/**
+ * @brief hold state of a thread that handle a block of keypads, it must be zero before first use
+ */
+typedef struct {
+#if KEYPAD_EVENT_QUEUE
+    KeyPad_EventQueue           Queue;                      /**< events of keypads of shard, KeyPad_dispatchShard fire them */
+    KeyPad_Tick                 Tick;                       /**< tick of shard, each KeyPad_handleShard is one tick */
+#endif // KEYPAD_EVENT_QUEUE
+    KeyPad_NumType              Keypads;                    /**< number of keypads that last KeyPad_handleShard scanned */
+    KeyPad_NumType              Index;                      /**< index of shard, 0 ~ num - 1, user set it before first use */
+} KeyPad_Shard;
+#endif // KEYPAD_SHARD
+#if KEYPAD_STATS
+/**
+ * @brief this function must return value of a free running counter, ex: cpu cycle counter or timer
+ */
+typedef uint32_t (*KeyPad_GetCyclesFn)(void);
+/**
+ * @brief hold counters of a keypad or sum of all keypads
+ */
+typedef struct {
+    uint32_t                    Scans;                      /**< number of scan steps */
+    uint32_t                    Reads;                      /**< number of readPin and readPort calls */
+    uint32_t                    Writes;                     /**< number of writePin and writePort calls */
+    uint32_t                    Callbacks;                  /**< number of user callbacks that called */
+    uint32_t                    Suppressed;                 /**< number of events that ignored because user handled key or key used in chord */
+} KeyPad_Counters;
+/**
+ * @brief hold histogram of durations in cycles of user clock, average is Sum / Count
+ */
+typedef struct {
+    uint32_t                    Count;
+    uint32_t                    Max;
+    uint64_t                    Sum;
+    uint32_t                    Bins[KEYPAD_STATS_BINS];    /**< bin N count samples in [2^N, 2^(N+1)), last bin count larger samples too */
+} KeyPad_Histogram;
+/**
+ * @brief hold stats of library
+ */
+typedef struct {
+    KeyPad_Counters             Counters;                   /**< sum of counters of all keypads */
+    KeyPad_Histogram            Handle;                     /**< duration of KeyPad_handle */
+    KeyPad_Histogram            Latency;                    /**< from start of KeyPad_handle that detect key to pressed callback */
+} KeyPad_Stats;
+#endif // KEYPAD_STATS
 /**
  * @brief hold minimum function for KeyPad lib to work
  * user must pass atleast init and read functions to keypad library
@@ -212,11 +603,37 @@ typedef struct {
     #if KEYPAD_USE_DEINIT
         KeyPad_DeInitPinFn   deinitPin;
     #endif
+    #if KEYPAD_USE_PORT
+        KeyPad_ReadPortFn    readPort;              /**< optional, can be null */
+        KeyPad_WritePortFn   writePort;             /**< optional, can be null */
+    #endif
+    #if KEYPAD_IDLE_WAKE
+        KeyPad_SetWakePinFn  setWakePin;            /**< optional, idle mode disabled if it's null */
+    #endif
+    #if KEYPAD_ANALOG
+        KeyPad_ReadAnalogFn  readAnalog;            /**< optional, just need for analog keypads */
+    #endif
 } KeyPad_Driver;
+#if KEYPAD_SHARD
+/**
+ * @brief a population of keypads with own driver, KeyPad_init, KeyPad_add and KeyPad_handle use default context
+ * it must be zero or init with KeyPad_initContext before use
+ */
+typedef struct {
+    const KeyPad_Driver*        Driver;
+    KeyPad*                     Active[KEYPAD_MAX_NUM];     /**< dense list of added keypads */
+    KeyPad_NumType              ActiveLen;
+#if KEYPAD_EVENT_QUEUE
+    KeyPad_Shard                Shard;                      /**< shard of KeyPad_handle and KeyPad_dispatch, only default context use it */
+#endif // KEYPAD_EVENT_QUEUE
+} KeyPad_Context;
+#endif // KEYPAD_SHARD
 
 
 // determine how many callbacks need
-#if KEYPAD_MULTI_CALLBACK && KEYPAD_NONE_CALLBACK
+#if KEYPAD_MULTI_CALLBACK && KEYPAD_HOLD_REPEAT
+    #define KEYPAD_CALLBACKS_NUM 6
+#elif KEYPAD_MULTI_CALLBACK && KEYPAD_NONE_CALLBACK
     #define KEYPAD_CALLBACKS_NUM 4
 #elif KEYPAD_MULTI_CALLBACK
     #define KEYPAD_CALLBACKS_NUM 3
@@ -231,9 +648,13 @@ typedef union {
         KeyPad_Callback        onPressed;  
         KeyPad_Callback        onHold;
         KeyPad_Callback        onReleased;        
-    #if KEYPAD_NONE_CALLBACK
+    #if KEYPAD_NONE_CALLBACK || KEYPAD_HOLD_REPEAT
         KeyPad_Callback        onNone;
-    #endif // KEYPAD_NONE_CALLBACK
+    #endif // KEYPAD_NONE_CALLBACK || KEYPAD_HOLD_REPEAT
+    #if KEYPAD_HOLD_REPEAT
+        KeyPad_Callback        onLongPress;
+        KeyPad_Callback        onRepeat;
+    #endif // KEYPAD_HOLD_REPEAT
     #else
         KeyPad_Callback        onChange;
     #endif // KEYPAD_MULTI_CALLBACK
@@ -247,24 +668,127 @@ typedef union {
 struct _KeyPad {
 #if KEYPAD_MAX_NUM == -1
     struct _KeyPad*             Previous;               	/**< point to previous keypad, if it's null show they keypad is end of linked list */
+    struct _KeyPad*             Next;                       /**< point to next keypad, if it's null show keypad is last keypad, keypads of user have no index so link stay a pointer */
 #endif // KEYPAD_MAX_NUM == -1
 #if KEYPAD_ARGS
     void*                       Args;                       /**< hold user arguments */
 #endif
     const KeyPad_Config*        Config;                 	/**< hold pointer to keypad configuration */
+#if KEYPAD_SHARED_CALLBACKS
+    const KeyPad_Callbacks*     Callbacks;                  /**< hold shared callback table, never null after add */
+#else
     KeyPad_Callbacks            Callbacks;                /**< hold user separate callbacks for each keypad state */
+#endif // KEYPAD_SHARED_CALLBACKS
+    // small fields stay together, so index, indices and flags fit in a single word
+#if KEYPAD_MAX_NUM != -1
+    KeyPad_NumType              Index;                      /**< index of keypad in active list, list link of fixed keypads */
+#endif // KEYPAD_MAX_NUM != -1
     KeyPad_LenType              RowIndex;                   /**< hold current row index */
     KeyPad_LenType              ColIndex;                   /**< hold current col index */
     uint8_t                     State           : 2;    	/**< show current state of keypad*/
     uint8_t                     NotActive       : 1;    	/**< show other states will be ignore or not */
     uint8_t                     ActiveState     : 1;    	/**< this parameters use only when Activestate Enabled */
+#if !KEYPAD_CONCURRENT
     uint8_t                     Configured      : 1;        /**< this flag shows KeyPad is configured or not, just useful fo fixed keypad num */
+#endif // !KEYPAD_CONCURRENT
     uint8_t                     Enabled         : 1;        /**< check this flag in irq */
-    uint8_t                     Reserved        : 2;
+    uint8_t                     Ghost           : 1;        /**< show last frame had ghost keys, just useful in nkro mode */
+    uint8_t                     LongPressed     : 1;        /**< show long press event fired for current key, just useful in hold repeat mode */
+#if KEYPAD_NKRO
+    KeyPad_PortMask             Frame[KEYPAD_NKRO_MAX_OUT];   /**< hold active inputs of each output in last frame */
+    KeyPad_PortMask             Handled[KEYPAD_NKRO_MAX_OUT]; /**< hold keys that user handled them, other states of them will be ignore */
+#endif // KEYPAD_NKRO
+#if KEYPAD_OUT_SHADOW
+    KeyPad_PortMask             OutShadow;                  /**< last written level of outputs, bit N is level of N-th output */
+#endif // KEYPAD_OUT_SHADOW
+#if KEYPAD_SCAN_BUDGET || KEYPAD_SCAN_PIPELINE
+    KeyPad_LenType              ScanIndex;                  /**< next output that scan, scan of keypad continue in next handle */
+#endif // KEYPAD_SCAN_BUDGET || KEYPAD_SCAN_PIPELINE
+#if KEYPAD_SCAN_PIPELINE
+    uint8_t                     SettleTicks;                /**< remaining handles until read of strobed output, 0 if no output strobed */
+#endif // KEYPAD_SCAN_PIPELINE
+#if KEYPAD_NKRO && (KEYPAD_SCAN_BUDGET || KEYPAD_SCAN_GROUP || KEYPAD_SCAN_PIPELINE)
+    KeyPad_PortMask             Scan[KEYPAD_NKRO_MAX_OUT];  /**< hold partial frame of scan, or frame that scanned by group */
+#endif // KEYPAD_NKRO && (KEYPAD_SCAN_BUDGET || KEYPAD_SCAN_GROUP || KEYPAD_SCAN_PIPELINE)
+#if KEYPAD_SCAN_GROUP
+    struct _KeyPad*             GroupNext;                  /**< next keypad of scan group, circular list, point to itself if keypad is alone */
+    uint8_t                     GroupScanned;               /**< Scan filled by other keypad of group in current handle */
+#endif // KEYPAD_SCAN_GROUP
+#if KEYPAD_HOLD_REPEAT
+    uint16_t                    HoldDelay;                  /**< ticks before long press event */
+    uint16_t                    RepeatDelay;                /**< ticks between repeat events */
+    uint16_t                    HoldTicks;                  /**< ticks from press or last event of current key */
+#endif // KEYPAD_HOLD_REPEAT
+#if KEYPAD_EVENT_QUEUE && !KEYPAD_NKRO
+    uint8_t                     Handled;                    /**< NotActive flag of dispatcher, only KeyPad_dispatch use it */
+#endif
+#if KEYPAD_CHORD
+    const KeyPad_Chords*        Chords;                     /**< chords of keypad, null if keypad has no chord */
+    KeyPad_Callback             ChordCallback;              /**< callback of chords, value is value of chord */
+    KeyPad_ChordMask            ChordDown;                  /**< chord keys that pressed now */
+    KeyPad_ChordMask            ChordPending;               /**< pressed keys that their pressed event held back */
+    KeyPad_ChordMask            ChordUsed;                  /**< keys of matched chords, their events ignored until release */
+    KeyPad_ChordRules           ChordRules;                 /**< chords that have all keys of ChordDown */
+    uint16_t                    ChordTicks;                 /**< ticks from first held back key */
+    uint8_t                     ChordIndex;                 /**< matched chord that its keys still hold, KEYPAD_CHORD_NONE if there is no chord */
+#endif // KEYPAD_CHORD
+#if KEYPAD_STATS
+    KeyPad_Counters             Stats;                      /**< counters of keypad, reset on add */
+#endif // KEYPAD_STATS
+#if KEYPAD_SHARD
+    KeyPad_Context*             Context;                    /**< context that keypad added to it */
+#if KEYPAD_EVENT_QUEUE
+    KeyPad_Shard*               Shard;                      /**< shard that scan keypad, events of keypad push into its queue */
+#endif // KEYPAD_EVENT_QUEUE
+#endif // KEYPAD_SHARD
+#if KEYPAD_CONCURRENT
+    const KeyPad_Config*        NewConfig;                  /**< config of KeyPad_setConfig, KeyPad_handle apply it before scan */
+    uint8_t                     Configured;                 /**< own byte, other context read it while KeyPad_handle change State */
+    uint8_t                     Retired;                    /**< keypad removed, only KeyPad_remove set it and KeyPad_add clear it */
+#endif // KEYPAD_CONCURRENT
+#if KEYPAD_DEBOUNCE
+#if KEYPAD_NKRO
+    KeyPad_PortMask             Debounce[KEYPAD_DEBOUNCE_BITS][KEYPAD_NKRO_MAX_OUT]; /**< bit-sliced debounce counters, one bit of each key in each slice */
+#else
+    uint8_t                     Debounce;                   /**< count continuous reads of current key that differ from state */
+#endif // KEYPAD_NKRO
+#endif // KEYPAD_DEBOUNCE
 };
 
 void KeyPad_init(const KeyPad_Driver* driver);
 void KeyPad_handle(void);
+uint8_t KeyPad_ctz(uint64_t value);
+
+#if KEYPAD_ADAPTIVE_RATE
+    KeyPad_Tick KeyPad_handleAt(KeyPad_Tick now);
+#endif // KEYPAD_ADAPTIVE_RATE
+
+#if KEYPAD_IDLE_WAKE
+    uint8_t KeyPad_isIdle(void);
+    void KeyPad_wake(void);
+#endif // KEYPAD_IDLE_WAKE
+
+#if KEYPAD_EVENT_QUEUE
+    uint16_t KeyPad_dispatch(void);
+    uint32_t KeyPad_getOverflow(void);
+#endif // KEYPAD_EVENT_QUEUE
+
+#if KEYPAD_SHARD
+    void KeyPad_initContext(KeyPad_Context* context, const KeyPad_Driver* driver);
+    KeyPad_Context* KeyPad_getContext(void);
+    uint8_t KeyPad_addContext(KeyPad_Context* context, KeyPad* keypad, const KeyPad_Config* config);
+    void KeyPad_handleShard(KeyPad_Context* context, KeyPad_Shard* shard, KeyPad_NumType num);
+#if KEYPAD_EVENT_QUEUE
+    uint16_t KeyPad_dispatchShard(KeyPad_Shard* shard);
+#endif // KEYPAD_EVENT_QUEUE
+#endif // KEYPAD_SHARD
+
+#if KEYPAD_STATS
+    void KeyPad_setStatsClock(KeyPad_GetCyclesFn fn);
+    const KeyPad_Stats* KeyPad_getStats(void);
+    const KeyPad_Counters* KeyPad_getCounters(KeyPad* keypad);
+    void KeyPad_resetStats(void);
+#endif // KEYPAD_STATS
 
 void KeyPad_setConfig(KeyPad* keypad, const KeyPad_Config* config);
 const KeyPad_Config* KeyPad_getConfig(KeyPad* keypad);
@@ -277,16 +801,23 @@ uint8_t KeyPad_add(KeyPad* keypad, const KeyPad_Config* config);
 uint8_t KeyPad_remove(KeyPad* remove);
 KeyPad* KeyPad_find(const KeyPad_Config* config);
 
-#if KEYPAD_MULTI_CALLBACK
+#if KEYPAD_SHARED_CALLBACKS
+    void KeyPad_setCallbacks(KeyPad* keypad, const KeyPad_Callbacks* callbacks);
+    const KeyPad_Callbacks* KeyPad_getCallbacks(KeyPad* keypad);
+#elif KEYPAD_MULTI_CALLBACK
     void KeyPad_onHold(KeyPad* keypad, KeyPad_Callback cb);
     void KeyPad_onReleased(KeyPad* keypad, KeyPad_Callback cb);
     void KeyPad_onPressed(KeyPad* keypad, KeyPad_Callback cb);
 #if KEYPAD_NONE_CALLBACK
     void KeyPad_onNone(KeyPad* keypad, KeyPad_Callback cb);
 #endif // KEYPAD_NONE_CALLBACK
+#if KEYPAD_HOLD_REPEAT
+    void KeyPad_onLongPress(KeyPad* keypad, KeyPad_Callback cb);
+    void KeyPad_onRepeat(KeyPad* keypad, KeyPad_Callback cb);
+#endif // KEYPAD_HOLD_REPEAT
 #else
     void KeyPad_onChange(KeyPad* keypad, KeyPad_Callback cb);
-#endif // KEYPAD_MULTI_CALLBACK
+#endif // KEYPAD_SHARED_CALLBACKS
 
 
 #if KEYPAD_ACTIVE_STATE
@@ -294,6 +825,31 @@ KeyPad* KeyPad_find(const KeyPad_Config* config);
     KeyPad_ActiveState KeyPad_getActiveState(KeyPad* keypad);
 #endif
 
+#if KEYPAD_NKRO
+    uint8_t KeyPad_isPressed(KeyPad* keypad, KeyPad_LenType outIndex, KeyPad_LenType inIndex);
+#if KEYPAD_NKRO_GHOST
+    uint8_t KeyPad_hasGhost(KeyPad* keypad);
+#endif // KEYPAD_NKRO_GHOST
+#endif // KEYPAD_NKRO
+
+#if KEYPAD_CHORD
+    uint8_t KeyPad_initChords(KeyPad_Chords* chords, const KeyPad_Chord* table, uint8_t len);
+    void KeyPad_setChords(KeyPad* keypad, const KeyPad_Chords* chords);
+    void KeyPad_onChord(KeyPad* keypad, KeyPad_Callback cb);
+#endif // KEYPAD_CHORD
+
+#if KEYPAD_FRAME_CAPTURE
+    uint8_t KeyPad_processFrame(KeyPad* keypad, const KeyPad_PortMask* inputs, KeyPad_LenType len);
+    KeyPad_LenType KeyPad_strobePattern(const KeyPad_Config* config, KeyPad_ActiveState state, KeyPad_PortMask* pattern);
+#endif // KEYPAD_FRAME_CAPTURE
+
+#if KEYPAD_HOLD_REPEAT
+    void KeyPad_setHoldDelay(KeyPad* keypad, uint16_t ticks);
+    uint16_t KeyPad_getHoldDelay(KeyPad* keypad);
+    void KeyPad_setRepeatDelay(KeyPad* keypad, uint16_t ticks);
+    uint16_t KeyPad_getRepeatDelay(KeyPad* keypad);
+#endif // KEYPAD_HOLD_REPEAT
+
 #if KEYPAD_ENABLE_FLAG
     void KeyPad_setEnabled(KeyPad* keypad, uint8_t enabled);
     uint8_t KeyPad_isEnabled(KeyPad* keypad);
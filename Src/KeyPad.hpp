@@ -0,0 +1,179 @@
+/**
+ * @file KeyPad.hpp
+ * @author Ali Mirghasemi (ali.mirghasemi1376@gmail.com)
+ * @brief compile-time specialized keypad for C++, dimensions, map and driver are template parameters
+ * so compiler can unroll scan loop and inline driver functions
+ * @version 0.1.0
+ * @date 2026-10-17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef _KEYPAD_HPP_
+#define _KEYPAD_HPP_
+
+#include "KeyPad.h"
+
+namespace KeyPadStatic {
+
+/**
+ * @brief call fn(I) for I in [BEGIN, END) until it return true
+ * recursion unroll loop in compile time
+ */
+template <KeyPad_LenType BEGIN, KeyPad_LenType END>
+struct Unroll {
+    template <typename Fn>
+    static inline bool until(Fn& fn) {
+        return fn(BEGIN) || Unroll<BEGIN + 1, END>::until(fn);
+    }
+};
+template <KeyPad_LenType END>
+struct Unroll<END, END> {
+    template <typename Fn>
+    static inline bool until(Fn&) {
+        return false;
+    }
+};
+
+/**
+ * @brief keypad with compile-time layout, same state machine as KeyPad_handle
+ *
+ * @tparam ROWS number of rows
+ * @tparam COLS number of columns
+ * @tparam MAP key map, MAP[row * COLS + col]
+ * @tparam Driver static policy class, pins addressed by index of output and input
+ *      static void initOut(KeyPad_LenType index);
+ *      static void initIn(KeyPad_LenType index, KeyPad_PinMode mode);
+ *      static void writeOut(KeyPad_LenType index, uint8_t value);
+ *      static uint8_t readIn(KeyPad_LenType index);
+ * @tparam ACTIVE_STATE active state of keypad
+ */
+template <KeyPad_LenType ROWS, KeyPad_LenType COLS, const KeyPad_KeyValue* MAP, typename Driver,
+          KeyPad_ActiveState ACTIVE_STATE = KeyPad_ActiveState_Low>
+class Matrix {
+public:
+    typedef KeyPad_HandleStatus (*Callback)(Matrix& keypad, KeyPad_KeyValue value, KeyPad_State state);
+
+#if KEYPAD_MODE == KEYPAD_MODE_ROW_INPUT
+    static constexpr KeyPad_LenType OutNum = COLS;
+    static constexpr KeyPad_LenType InNum = ROWS;
+#else
+    static constexpr KeyPad_LenType OutNum = ROWS;
+    static constexpr KeyPad_LenType InNum = COLS;
+#endif
+
+    Matrix() :
+        callbacks(),
+        outIndex(0),
+        inIndex(0),
+        state(KeyPad_State_None),
+        notActive(KeyPad_NotHandled)
+    {}
+    /**
+     * @brief init pins, outputs start in inactive state
+     */
+    void init(void) {
+        InitPins fn;
+        Unroll<0, (OutNum > InNum ? OutNum : InNum)>::until(fn);
+        state = KeyPad_State_None;
+        notActive = KeyPad_NotHandled;
+    }
+    /**
+     * @brief user must place it in timer, same as KeyPad_handle for a keypad
+     */
+    inline void handle(void) {
+        if (state == KeyPad_State_None) {
+            ScanKeys fn(*this);
+        #if KEYPAD_NONE_CALLBACK
+            if (!Unroll<0, OutNum>::until(fn)) {
+                fire(KEYPAD_KEY_NONE);
+            }
+        #else
+            Unroll<0, OutNum>::until(fn);
+        #endif // KEYPAD_NONE_CALLBACK
+        }
+        else {
+            state = Driver::readIn(inIndex) == ACTIVE_STATE ? KeyPad_State_Hold : KeyPad_State_Released;
+            if (!notActive) {
+                fire(value(outIndex, inIndex));
+            }
+            if (state == KeyPad_State_Released) {
+                state = KeyPad_State_None;
+                Driver::writeOut(outIndex, !ACTIVE_STATE);
+            }
+        }
+    }
+
+    inline void onPressed(Callback cb) { callbacks[KeyPad_State_Pressed] = cb; }
+    inline void onHold(Callback cb) { callbacks[KeyPad_State_Hold] = cb; }
+    inline void onReleased(Callback cb) { callbacks[KeyPad_State_Released] = cb; }
+#if KEYPAD_NONE_CALLBACK
+    inline void onNone(Callback cb) { callbacks[KeyPad_State_None] = cb; }
+#endif // KEYPAD_NONE_CALLBACK
+
+    inline KeyPad_State getState(void) const { return (KeyPad_State) state; }
+
+    static constexpr KeyPad_KeyValue value(KeyPad_LenType out, KeyPad_LenType in) {
+    #if KEYPAD_MODE == KEYPAD_MODE_ROW_INPUT
+        return MAP[in * COLS + out];
+    #else
+        return MAP[out * COLS + in];
+    #endif
+    }
+
+private:
+    struct InitPins {
+        inline bool operator()(KeyPad_LenType index) {
+            if (index < OutNum) {
+                Driver::writeOut(index, !ACTIVE_STATE);
+                Driver::initOut(index);
+            }
+            if (index < InNum) {
+                Driver::initIn(index, (KeyPad_PinMode) ACTIVE_STATE);
+            }
+            return false;
+        }
+    };
+    struct FindIn {
+        KeyPad_LenType index;
+        inline bool operator()(KeyPad_LenType in) {
+            index = in;
+            return Driver::readIn(in) == ACTIVE_STATE;
+        }
+    };
+    struct ScanKeys {
+        Matrix& keypad;
+        explicit ScanKeys(Matrix& k) : keypad(k) {}
+        inline bool operator()(KeyPad_LenType out) {
+            FindIn find;
+            Driver::writeOut(out, ACTIVE_STATE);
+            if (Unroll<0, InNum>::until(find)) {
+                // key pressed
+                keypad.state = KeyPad_State_Pressed;
+                keypad.outIndex = out;
+                keypad.inIndex = find.index;
+                keypad.fire(value(out, find.index));
+                return true;
+            }
+            Driver::writeOut(out, !ACTIVE_STATE);
+            return false;
+        }
+    };
+
+    inline void fire(KeyPad_KeyValue key) {
+        if (callbacks[state]) {
+            notActive = callbacks[state](*this, key, (KeyPad_State) state);
+        }
+    }
+
+    Callback            callbacks[4];
+    KeyPad_LenType      outIndex;
+    KeyPad_LenType      inIndex;
+    uint8_t             state;
+    uint8_t             notActive;
+};
+
+}
+
+#endif /* _KEYPAD_HPP_ */